@@ -0,0 +1,142 @@
+#include <libinfisical/InfisicalClient.h>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Local cache daemon: logs in once, keeps the configured scopes in memory and serves them to processes of the same user over a Unix socket.
+// Clients opt in with `ConfigBuilder().withAgentSocket(path)`.
+
+namespace
+{
+  Infisical::agent::AgentServer *runningServer = nullptr;
+
+  void handleSignal(int)
+  {
+    if (runningServer != nullptr)
+    {
+      runningServer->stop();
+    }
+  }
+
+  void printUsage(const char *program)
+  {
+    std::cerr << "Usage: " << program << " --socket PATH --scope PROJECT_ID:ENVIRONMENT[:SECRET_PATH] [--scope ...]\n"
+              << "         [--host URL] [--refresh SECONDS] [--jitter FRACTION] [--recursive] [--no-expand]\n\n"
+              << "Credentials are read from INFISICAL_MACHINE_IDENTITY_CLIENT_ID and INFISICAL_MACHINE_IDENTITY_CLIENT_SECRET." << std::endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string socketPath;
+  std::string hostUrl = "https://app.infisical.com";
+  std::vector<std::string> scopeArgs;
+  long refreshSeconds = 60;
+  double jitter = 0.1;
+  bool recursive = false;
+  bool expandSecretReferences = true;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--socket" && hasValue)
+    {
+      socketPath = argv[++i];
+    }
+    else if (arg == "--scope" && hasValue)
+    {
+      scopeArgs.push_back(argv[++i]);
+    }
+    else if (arg == "--host" && hasValue)
+    {
+      hostUrl = argv[++i];
+    }
+    else if (arg == "--refresh" && hasValue)
+    {
+      refreshSeconds = std::strtol(argv[++i], nullptr, 10);
+    }
+    else if (arg == "--jitter" && hasValue)
+    {
+      jitter = std::strtod(argv[++i], nullptr);
+    }
+    else if (arg == "--recursive")
+    {
+      recursive = true;
+    }
+    else if (arg == "--no-expand")
+    {
+      expandSecretReferences = false;
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (socketPath.empty() || scopeArgs.empty() || refreshSeconds <= 0 || !(jitter >= 0 && jitter < 1))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<Infisical::Input::ListSecretsOptions> scopes;
+  for (const auto &scopeArg : scopeArgs)
+  {
+    auto first = scopeArg.find(':');
+    if (first == std::string::npos || first == 0)
+    {
+      std::cerr << "Invalid scope: " << scopeArg << std::endl;
+      return 1;
+    }
+    auto second = scopeArg.find(':', first + 1);
+
+    scopes.push_back(Infisical::Input::ListSecretOptionsBuilder()
+                         .withProjectId(scopeArg.substr(0, first))
+                         .withEnvironment(scopeArg.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1))
+                         .withSecretPath(second == std::string::npos ? "/" : scopeArg.substr(second + 1))
+                         .withRecursive(recursive)
+                         .withExpandSecretReferences(expandSecretReferences)
+                         .build());
+  }
+
+  try
+  {
+    Infisical::InfisicalClient client(
+        Infisical::ConfigBuilder()
+            .withHostUrl(hostUrl)
+            .withAuthentication(
+                Infisical::AuthenticationBuilder()
+                    .withUniversalAuth()
+                    .build())
+            .build());
+
+    Infisical::agent::AgentServer server(client, socketPath, std::move(scopes), std::chrono::seconds(refreshSeconds));
+    server.setRefreshJitter(jitter);
+    server.setErrorHandler([](const std::string &error)
+                           { std::cerr << error << std::endl; });
+
+    if (!server.refresh())
+    {
+      std::cerr << "Some scopes could not be loaded, they will be retried every " << refreshSeconds << "s" << std::endl;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    std::cerr << "Serving secrets on " << socketPath << std::endl;
+    server.serve();
+    runningServer = nullptr;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,118 @@
+#include <libinfisical/InfisicalClient.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts heap allocations made while building GetSecretOptions and handing them to a client method, for the copying and the moving call patterns.
+
+namespace
+{
+  std::atomic<size_t> allocations{0};
+  volatile size_t sink = 0;
+}
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+  // stands in for SecretsClient::getSecret(), which now takes the options by const reference
+  __attribute__((noinline)) size_t consume(const Infisical::Input::GetSecretOptions &options)
+  {
+    return options.getSecretKey().size() + options.getSecretPath().size();
+  }
+
+  // the previous signature took the options by value
+  __attribute__((noinline)) size_t consumeByValue(Infisical::Input::GetSecretOptions options)
+  {
+    return options.getSecretKey().size() + options.getSecretPath().size();
+  }
+
+  const std::string projectId = "6f1c2d3e-4a5b-4c6d-8e9f-0a1b2c3d4e5f";
+  const std::string environment = "production";
+  const std::string secretPath = "/services/payments/database";
+  const std::string secretKey = "DATABASE_CONNECTION_STRING";
+
+  // setters copy from lvalues, build() copies out of the builder, the call copies into the parameter
+  size_t copying()
+  {
+    Infisical::Input::GetSecretOptionsBuilder builder;
+    builder.withProjectId(projectId)
+        .withEnvironment(environment)
+        .withSecretPath(secretPath)
+        .withSecretKey(secretKey);
+    auto options = builder.build();
+    return consumeByValue(options);
+  }
+
+  // temporaries are moved into the builder, build() && moves the options out, the call binds by reference
+  size_t moving()
+  {
+    return consume(Infisical::Input::GetSecretOptionsBuilder()
+                       .withProjectId(std::string(projectId))
+                       .withEnvironment(std::string(environment))
+                       .withSecretPath(std::string(secretPath))
+                       .withSecretKey(std::string(secretKey))
+                       .build());
+  }
+
+  // literals still construct one std::string each, but nothing after that copies them
+  size_t literals()
+  {
+    return consume(Infisical::Input::GetSecretOptionsBuilder()
+                       .withProjectId("6f1c2d3e-4a5b-4c6d-8e9f-0a1b2c3d4e5f")
+                       .withEnvironment("production")
+                       .withSecretPath("/services/payments/database")
+                       .withSecretKey("DATABASE_CONNECTION_STRING")
+                       .build());
+  }
+
+  template <typename Fn>
+  void run(const char *name, Fn fn, size_t iterations)
+  {
+    const auto before = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+      sink = sink + fn();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto count = allocations.load() - before;
+
+    printf("%-10s %-18.2f %-12.1f\n",
+           name,
+           static_cast<double>(count) / iterations,
+           std::chrono::duration<double, std::nano>(elapsed).count() / iterations);
+  }
+}
+
+int main()
+{
+  const size_t iterations = 1000000;
+
+  printf("%-10s %-18s %-12s\n", "pattern", "allocations/op", "ns/op");
+  run("copying", copying, iterations);
+  run("moving", moving, iterations);
+  run("literals", literals, iterations);
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <libinfisical/InfisicalClient.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Compares the default std::string storage with the pooled, locked SecureString used when building with INFISICAL_SECURE_MEMORY.
+
+template <typename String>
+double benchmarkCreateDestroy(size_t valueSize, size_t iterations)
+{
+  const std::string source(valueSize, 'x');
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+  {
+    String value(source.data(), source.size());
+    Infisical::secure::wipe(value);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+template <typename String>
+double benchmarkBatch(size_t valueSize, size_t batchSize, size_t rounds)
+{
+  const std::string source(valueSize, 'x');
+  std::vector<String> values;
+  values.reserve(batchSize);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    for (size_t i = 0; i < batchSize; i++)
+    {
+      values.emplace_back(source.data(), source.size());
+    }
+    for (auto &value : values)
+    {
+      Infisical::secure::wipe(value);
+    }
+    values.clear();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (batchSize * rounds);
+}
+
+int main()
+{
+  const size_t iterations = 2000000;
+  const size_t sizes[] = {8, 32, 256, 2048, 16384};
+
+  printf("secure pool pages locked: %s\n\n", Infisical::secure::isMemoryLocked() ? "yes" : "no");
+  printf("%-10s %-22s %-22s %-22s %-22s\n", "size", "std::string ns/op", "SecureString ns/op", "std::string batch", "SecureString batch");
+
+  for (auto size : sizes)
+  {
+    const auto n = size > 4096 ? iterations / 20 : iterations;
+    printf("%-10zu %-22.1f %-22.1f %-22.1f %-22.1f\n",
+           size,
+           benchmarkCreateDestroy<std::string>(size, n),
+           benchmarkCreateDestroy<Infisical::secure::SecureString>(size, n),
+           benchmarkBatch<std::string>(size, 1000, n / 1000),
+           benchmarkBatch<Infisical::secure::SecureString>(size, 1000, n / 1000));
+  }
+
+  printf("\nsecure pool pages locked: %s\n", Infisical::secure::isMemoryLocked() ? "yes" : "no");
+  return 0;
+}
@@ -0,0 +1,273 @@
+#include <libinfisical/InfisicalClient.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// Measures what sharing TLS sessions between requests saves. A local TLS server closes the connection after every response,
+// so each request needs a new handshake: a full one for a client that shares nothing between requests, a resumed one for a
+// client that keeps the sessions in its connection share.
+//
+// Usage: benchmark_tls_handshakes [--iterations N]
+
+namespace
+{
+  const char *STATUS_RESPONSE = R"({"message":"Ok","emailConfigured":false,"redisConfigured":true})";
+
+  // self-signed P-256 certificate for 127.0.0.1, written to a temporary file the clients use as their CA bundle
+  struct Certificate
+  {
+    EVP_PKEY *key = nullptr;
+    X509 *certificate = nullptr;
+    std::string path;
+
+    Certificate()
+    {
+      // EVP_EC_gen() would be shorter, but it's OpenSSL 3.0 only
+      EVP_PKEY_CTX *keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+      if (keyContext == nullptr ||
+          EVP_PKEY_keygen_init(keyContext) <= 0 ||
+          EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext, NID_X9_62_prime256v1) <= 0 ||
+          EVP_PKEY_keygen(keyContext, &key) <= 0)
+      {
+        key = nullptr;
+      }
+      EVP_PKEY_CTX_free(keyContext);
+      certificate = X509_new();
+      if (key == nullptr || certificate == nullptr)
+      {
+        fail("certificate");
+      }
+
+      X509_set_version(certificate, 2);
+      ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+      X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+      X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60);
+      X509_set_pubkey(certificate, key);
+
+      X509_NAME *name = X509_get_subject_name(certificate);
+      X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("127.0.0.1"), -1, -1, 0);
+      X509_set_issuer_name(certificate, name);
+
+      X509V3_CTX context;
+      X509V3_set_ctx_nodb(&context);
+      X509V3_set_ctx(&context, certificate, certificate, nullptr, nullptr, 0);
+      for (auto [nid, value] : {std::pair{NID_subject_alt_name, "IP:127.0.0.1"}, std::pair{NID_basic_constraints, "critical,CA:TRUE"}})
+      {
+        X509_EXTENSION *extension = X509V3_EXT_conf_nid(nullptr, &context, nid, value);
+        X509_add_ext(certificate, extension, -1);
+        X509_EXTENSION_free(extension);
+      }
+      if (X509_sign(certificate, key, EVP_sha256()) == 0)
+      {
+        fail("certificate");
+      }
+
+      char file[] = "/tmp/infisical-benchmark-ca-XXXXXX";
+      int fd = ::mkstemp(file);
+      FILE *out = fd < 0 ? nullptr : ::fdopen(fd, "w");
+      if (out == nullptr || PEM_write_X509(out, certificate) == 0)
+      {
+        fail("certificate file");
+      }
+      std::fclose(out);
+      path = file;
+    }
+
+    ~Certificate()
+    {
+      ::unlink(path.c_str());
+      X509_free(certificate);
+      EVP_PKEY_free(key);
+    }
+
+    static void fail(const char *what)
+    {
+      fprintf(stderr, "%s: ", what);
+      ERR_print_errors_fp(stderr);
+      fprintf(stderr, "\n");
+      std::exit(1);
+    }
+  };
+
+  // one request per connection, like a server or load balancer that doesn't keep connections alive
+  class LocalTlsServer
+  {
+  public:
+    explicit LocalTlsServer(const Certificate &certificate)
+    {
+      _context = SSL_CTX_new(TLS_server_method());
+      if (_context == nullptr ||
+          SSL_CTX_use_certificate(_context, certificate.certificate) != 1 ||
+          SSL_CTX_use_PrivateKey(_context, certificate.key) != 1)
+      {
+        Certificate::fail("server context");
+      }
+
+      _listener = ::socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t length = sizeof(address);
+      if (_listener < 0 ||
+          ::bind(_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+          ::listen(_listener, 16) != 0 ||
+          ::getsockname(_listener, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+      {
+        perror("local server");
+        std::exit(1);
+      }
+      _port = ntohs(address.sin_port);
+      _thread = std::thread([this]()
+                            { serve(); });
+    }
+
+    ~LocalTlsServer()
+    {
+      _stopped = true;
+      ::shutdown(_listener, SHUT_RDWR);
+      ::close(_listener);
+      _thread.join();
+      SSL_CTX_free(_context);
+    }
+
+    std::string url() const { return "https://127.0.0.1:" + std::to_string(_port); }
+
+    size_t handshakes() const { return _handshakes; }
+    size_t resumedHandshakes() const { return _resumed; }
+
+    void resetCounters()
+    {
+      _handshakes = 0;
+      _resumed = 0;
+    }
+
+  private:
+    SSL_CTX *_context = nullptr;
+    int _listener = -1;
+    uint16_t _port = 0;
+    std::atomic<bool> _stopped{false};
+    std::atomic<size_t> _handshakes{0};
+    std::atomic<size_t> _resumed{0};
+    std::thread _thread;
+
+    void serve()
+    {
+      while (!_stopped)
+      {
+        int connection = ::accept(_listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+          continue;
+        }
+        SSL *ssl = SSL_new(_context);
+        SSL_set_fd(ssl, connection);
+        if (SSL_accept(ssl) == 1)
+        {
+          _handshakes++;
+          if (SSL_session_reused(ssl))
+          {
+            _resumed++;
+          }
+          handle(ssl);
+        }
+        SSL_free(ssl);
+        ::close(connection);
+      }
+    }
+
+    void handle(SSL *ssl)
+    {
+      std::string request;
+      char chunk[4096];
+      while (request.find("\r\n\r\n") == std::string::npos)
+      {
+        int n = SSL_read(ssl, chunk, sizeof(chunk));
+        if (n <= 0)
+        {
+          return;
+        }
+        request.append(chunk, static_cast<size_t>(n));
+      }
+
+      const std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\nContent-Length: " +
+                                   std::to_string(std::strlen(STATUS_RESPONSE)) + "\r\n\r\n" + STATUS_RESPONSE;
+      SSL_write(ssl, response.data(), static_cast<int>(response.size()));
+      SSL_shutdown(ssl);
+    }
+  };
+
+  struct Run
+  {
+    double microsecondsPerRequest;
+    size_t handshakes;
+    size_t resumed;
+  };
+
+  template <typename Request>
+  Run measure(LocalTlsServer &server, size_t iterations, Request request)
+  {
+    server.resetCounters();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+      request();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return Run{std::chrono::duration<double, std::micro>(elapsed).count() / iterations, server.handshakes(), server.resumedHandshakes()};
+  }
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = 500;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (std::strcmp(argv[i], "--iterations") == 0)
+    {
+      iterations = std::strtoul(argv[i + 1], nullptr, 10);
+    }
+  }
+
+  Certificate certificate;
+  LocalTlsServer server(certificate);
+
+  // what every request paid before: a session of its own, nothing carried over from earlier requests
+  const auto isolated = measure(server, iterations, [&]()
+                                {
+                                  Infisical::http::HttpClient client(server.url());
+                                  client.setCaBundle(certificate.path);
+                                  client.get("/api/status"); });
+
+  Infisical::http::HttpClient client(server.url());
+  client.setCaBundle(certificate.path);
+  client.get("/api/status"); // the one full handshake that the others resume
+  const auto shared = measure(server, iterations, [&]()
+                              { client.get("/api/status"); });
+
+  printf("%-10s %-12s %-12s %-10s\n", "sessions", "us/request", "handshakes", "resumed");
+  printf("%-10s %-12.1f %-12zu %-10zu\n", "isolated", isolated.microsecondsPerRequest, isolated.handshakes, isolated.resumed);
+  printf("%-10s %-12.1f %-12zu %-10zu\n", "shared", shared.microsecondsPerRequest, shared.handshakes, shared.resumed);
+  printf("shared sessions save %.1f%% per request\n",
+         100.0 * (1.0 - shared.microsecondsPerRequest / isolated.microsecondsPerRequest));
+
+  if (shared.resumed < shared.handshakes)
+  {
+    fprintf(stderr, "only %zu of %zu handshakes were resumed with shared sessions\n", shared.resumed, shared.handshakes);
+    return 1;
+  }
+  return 0;
+}
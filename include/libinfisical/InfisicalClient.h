@@ -1,6 +1,23 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
+#include <list>
+#include <type_traits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
 #include "../../lib/json.hpp"
 #include <cpr/cpr.h>
 
@@ -58,6 +75,19 @@ namespace Infisical
           m_statusCode(statusCode),
           m_response(response) {}
 
+    /**
+     * Error for an HTTP response with a non-success status. Nothing is parsed or formatted up front: the request ID,
+     * the server's message and `what()` are worked out from the response body the first time one of them is asked for.
+     * @param statusCode HTTP status code
+     * @param method HTTP method of the request
+     * @param url Full URL of the request
+     * @param path Endpoint path of the request, without the host
+     * @param response Full response text, moved in
+     */
+    InfisicalError(int statusCode, std::string method, std::string url, std::string path, std::string response);
+
+    const char *what() const noexcept override;
+
     /**
      * Get the HTTP status code that caused this error
      * @return HTTP status code
@@ -70,9 +100,252 @@ namespace Infisical
      */
     const std::string &getResponse() const { return m_response; }
 
+    /**
+     * HTTP method of the failed request, empty if the error didn't come from an HTTP response
+     */
+    const std::string &getMethod() const;
+
+    /**
+     * Endpoint path of the failed request, empty if the error didn't come from an HTTP response
+     */
+    const std::string &getPath() const;
+
+    /**
+     * Request ID reported by the server, empty if there was none
+     */
+    const std::string &getRequestId() const;
+
+    /**
+     * Message reported by the server, empty if there was none
+     */
+    const std::string &getServerMessage() const;
+
   private:
+    struct HttpDetails;
+
     int m_statusCode;
     std::string m_response;
+    // shared between copies, so an error rethrown on another thread is still only parsed once
+    std::shared_ptr<HttpDetails> m_http;
+
+    const HttpDetails &parsedDetails() const;
+  };
+
+  /**
+   * Either a value or the `InfisicalError` that prevented it, for calls where a failure is an expected outcome and unwinding an exception for it would be wasted work.
+   */
+  template <typename T>
+  class Result
+  {
+  public:
+    Result(T value) : _value(std::move(value)) {}
+    Result(InfisicalError error) : _error(std::move(error)) {}
+
+    bool ok() const { return _value.has_value(); }
+    explicit operator bool() const { return ok(); }
+
+    /**
+     * The value, or throws the error if there is none
+     */
+    T &value() &
+    {
+      if (!_value)
+      {
+        throw *_error;
+      }
+      return *_value;
+    }
+
+    const T &value() const &
+    {
+      if (!_value)
+      {
+        throw *_error;
+      }
+      return *_value;
+    }
+
+    T value() &&
+    {
+      if (!_value)
+      {
+        throw std::move(*_error);
+      }
+      return std::move(*_value);
+    }
+
+    /**
+     * The error. Only valid if `ok()` is false.
+     */
+    const InfisicalError &error() const { return *_error; }
+
+  private:
+    std::optional<T> _value;
+    std::optional<InfisicalError> _error;
+  };
+
+  // ------------------------ DEADLINES
+  /**
+   * Puts a deadline on every request the current thread makes while the scope is alive, including the login a secrets call may need first and the
+   * parallel fetches of `listSecretsMulti()`, which carry it to the threads they run on. Waiting for a login another call already started stops at the deadline too.
+   * Nested scopes can only shorten it. A request that can't be sent before the deadline, or would have to queue past it for the rate limiter, fails with an `InfisicalError` (status code 0) without being sent.
+   */
+  class DeadlineScope
+  {
+  public:
+    explicit DeadlineScope(std::chrono::steady_clock::time_point deadline);
+    explicit DeadlineScope(std::chrono::milliseconds budget);
+    ~DeadlineScope();
+    DeadlineScope(const DeadlineScope &) = delete;
+    DeadlineScope &operator=(const DeadlineScope &) = delete;
+
+    /**
+     * The deadline of the innermost scope on this thread, if there is one
+     */
+    static std::optional<std::chrono::steady_clock::time_point> current();
+
+  private:
+    std::optional<std::chrono::steady_clock::time_point> _previous;
+  };
+
+  // ------------------------ SECURE MEMORY
+  namespace secure
+  {
+    /**
+     * Overwrite `size` bytes at `data` with zeroes in a way the compiler can't optimize away.
+     */
+    void wipe(void *data, size_t size);
+
+    /**
+     * Allocate memory from the secure pool. Pool pages are locked into RAM (`mlock`) so they are never swapped to disk, and excluded from core dumps where supported.
+     * Small sizes are served from per-size-class free lists, so steady-state allocations don't hit the kernel.
+     */
+    void *allocate(size_t size);
+
+    /**
+     * Zeroize and return memory obtained from `allocate()` to the pool. `size` must be the size that was requested.
+     */
+    void deallocate(void *data, size_t size);
+
+    /**
+     * Returns false if the OS refused to lock pool pages (e.g. because of `RLIMIT_MEMLOCK`). Memory is still zeroized on release in that case.
+     */
+    bool isMemoryLocked();
+
+    /**
+     * Fork hooks of the secure pool, run by `Infisical::prepareFork()` and friends. Memory locks aren't inherited by a child process, so the child locks the pool's pages again.
+     */
+    void prepareFork();
+    void afterForkInParent();
+    void afterForkInChild();
+
+    template <typename T>
+    struct SecureAllocator
+    {
+      using value_type = T;
+
+      SecureAllocator() noexcept = default;
+      template <typename U>
+      SecureAllocator(const SecureAllocator<U> &) noexcept {}
+
+      T *allocate(size_t n) { return static_cast<T *>(secure::allocate(n * sizeof(T))); }
+      void deallocate(T *p, size_t n) noexcept { secure::deallocate(p, n * sizeof(T)); }
+
+      template <typename U>
+      bool operator==(const SecureAllocator<U> &) const noexcept { return true; }
+      template <typename U>
+      bool operator!=(const SecureAllocator<U> &) const noexcept { return false; }
+    };
+
+    using SecureString = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
+
+    /**
+     * Zeroize the contents of a string, including short strings stored inline in the string object itself.
+     * The whole capacity is cleared, past `size()` it can still hold a longer value written earlier or a short one a move left behind.
+     */
+    template <typename Allocator>
+    void wipe(std::basic_string<char, std::char_traits<char>, Allocator> &str)
+    {
+      // growing within the capacity never reallocates
+      str.resize(str.capacity());
+      wipe(&str[0], str.size());
+      str.clear();
+    }
+
+    /**
+     * Zeroize every string and number in a JSON document, e.g. a parsed response that held secret values. Object keys are left as they are.
+     */
+    void wipe(nlohmann::json &value);
+  }
+
+  /**
+   * String type used for secret values and credentials.
+   * Building with `INFISICAL_SECURE_MEMORY` (CMake option of the same name) switches it from `std::string` to `secure::SecureString`, which keeps the contents in locked memory and zeroizes it on release.
+   */
+#ifdef INFISICAL_SECURE_MEMORY
+  using SecretString = secure::SecureString;
+#else
+  using SecretString = std::string;
+#endif
+
+  // ------------------------ FORK SUPPORT
+
+  /**
+   * Quiesce every live `InfisicalClient` and `ClientManager` before fork(): wait for in-flight logins and worker tasks and take their locks.
+   * Must be followed by `afterForkInParent()` in the parent and `afterForkInChild()` in the child.
+   * Throws `std::logic_error` when called from the SDK's own background threads (worker-pool tasks, scheduled tasks, login observers), which would
+   * wait for themselves. Under `installForkHandlers()` that means a fork() from such a thread terminates the process instead of deadlocking it.
+   */
+  void prepareFork();
+
+  /**
+   * Release what `prepareFork()` took, background work resumes.
+   */
+  void afterForkInParent();
+
+  /**
+   * Give the child its own connections, agent socket and worker threads. Tokens and secrets already in memory are kept, so the child doesn't log in or fetch again.
+   */
+  void afterForkInChild();
+
+  /**
+   * Register the three functions above with pthread_atfork(), so every fork() runs them. Safe to call more than once. Does nothing on Windows.
+   */
+  void installForkHandlers();
+
+  /**
+   * Marks the current thread as running SDK background work while the scope is alive, see `prepareFork()`.
+   */
+  class BackgroundTaskScope
+  {
+  public:
+    BackgroundTaskScope();
+    ~BackgroundTaskScope();
+    BackgroundTaskScope(const BackgroundTaskScope &) = delete;
+    BackgroundTaskScope &operator=(const BackgroundTaskScope &) = delete;
+
+    static bool active();
+
+  private:
+    bool _previous;
+  };
+
+  /**
+   * Object brought into a safe state around fork() by the functions above. Objects register themselves once fully constructed.
+   */
+  class ForkAware
+  {
+  public:
+    virtual void prepareFork() = 0;
+    virtual void afterForkInParent() = 0;
+    virtual void afterForkInChild() = 0;
+
+  protected:
+    ForkAware() = default;
+    ~ForkAware() = default;
+
+    void registerForFork();
+    void unregisterForFork();
   };
 
   // forward refs
@@ -80,6 +353,7 @@ namespace Infisical
   class Config;
   class AuthenticationBuilder;
   class Authentication;
+  class RefreshScheduler;
 
   namespace Secrets
   {
@@ -96,6 +370,11 @@ namespace Infisical
     class HttpClient;
   }
 
+  namespace agent
+  {
+    class AgentClient;
+  }
+
   // --------------------- INPUTS
 
   namespace Input
@@ -186,7 +465,7 @@ namespace Infisical
       std::string _environment;
       std::string _secretPath = "/";
       std::string _type = "shared";
-      unsigned int _version;
+      unsigned int _version = 0;
       bool _expandSecretReferences = true;
 
       friend class GetSecretOptionsBuilder;
@@ -201,6 +480,15 @@ namespace Infisical
       bool getExpandSecretReferences() const { return _expandSecretReferences; }
     };
 
+    /**
+     * What to do when a secret key collides with an environment variable that is already set.
+     */
+    enum class EnvironmentVariableOverwritePolicy
+    {
+      SKIP_EXISTING,
+      OVERWRITE
+    };
+
     class ListSecretsOptions
     {
     private:
@@ -208,8 +496,9 @@ namespace Infisical
       std::string _environment;
       std::string _secretPath = "/";
       std::vector<std::string> _tagSlugs;
-      bool _addSecretsToEnvironmentVariables;
-      bool _recursive;
+      bool _addSecretsToEnvironmentVariables = false;
+      EnvironmentVariableOverwritePolicy _environmentVariableOverwritePolicy = EnvironmentVariableOverwritePolicy::SKIP_EXISTING;
+      bool _recursive = false;
       bool _expandSecretReferences = true;
 
       friend class ListSecretOptionsBuilder;
@@ -223,6 +512,7 @@ namespace Infisical
       const std::vector<std::string> &getTagSlugs() const { return _tagSlugs; }
       bool getRecursive() const { return _recursive; }
       bool getAddSecretsToEnvironmentVariables() const { return _addSecretsToEnvironmentVariables; }
+      EnvironmentVariableOverwritePolicy getEnvironmentVariableOverwritePolicy() const { return _environmentVariableOverwritePolicy; }
       bool getExpandSecretReferences() const { return _expandSecretReferences; }
     };
 
@@ -230,69 +520,123 @@ namespace Infisical
     {
       ListSecretsOptions _options;
 
-    public:
-      ListSecretOptionsBuilder() = default;
-
-      ListSecretsOptions build()
+      void validate() const
       {
         if (_options._projectId.empty() || _options._environment.empty())
         {
           throw std::invalid_argument("ListSecretOptions: Project ID and Environment cannot be empty");
         }
+      }
+
+    public:
+      ListSecretOptionsBuilder() = default;
+
+      ListSecretsOptions build() const &
+      {
+        validate();
         return _options;
       }
 
-      ListSecretOptionsBuilder &withProjectId(const std::string &value)
+      ListSecretsOptions build() &&
+      {
+        validate();
+        return std::move(_options);
+      }
+
+      ListSecretOptionsBuilder &withProjectId(std::string value) &
       {
-        _options._projectId = value;
+        _options._projectId = std::move(value);
         return *this;
       }
 
-      ListSecretOptionsBuilder &withEnvironment(const std::string &value)
+      ListSecretOptionsBuilder &&withProjectId(std::string value) &&
+      {
+        return std::move(withProjectId(std::move(value)));
+      }
+
+      ListSecretOptionsBuilder &withEnvironment(std::string value) &
       {
-        _options._environment = value;
+        _options._environment = std::move(value);
         return *this;
       }
 
-      ListSecretOptionsBuilder &withSecretPath(const std::string &value)
+      ListSecretOptionsBuilder &&withEnvironment(std::string value) &&
       {
-        _options._secretPath = value;
+        return std::move(withEnvironment(std::move(value)));
+      }
+
+      ListSecretOptionsBuilder &withSecretPath(std::string value) &
+      {
+        _options._secretPath = std::move(value);
         return *this;
       }
 
-      ListSecretOptionsBuilder &withRecursive(bool value)
+      ListSecretOptionsBuilder &&withSecretPath(std::string value) &&
+      {
+        return std::move(withSecretPath(std::move(value)));
+      }
+
+      ListSecretOptionsBuilder &withRecursive(bool value) &
       {
         _options._recursive = value;
         return *this;
       }
 
-      ListSecretOptionsBuilder &withAddSecretsToEnvironmentVariables(bool value)
+      ListSecretOptionsBuilder &&withRecursive(bool value) &&
+      {
+        return std::move(withRecursive(value));
+      }
+
+      ListSecretOptionsBuilder &withAddSecretsToEnvironmentVariables(bool value) &
       {
         _options._addSecretsToEnvironmentVariables = value;
         return *this;
       }
 
-      ListSecretOptionsBuilder &withTagSlugs(const std::vector<std::string> &values)
+      ListSecretOptionsBuilder &&withAddSecretsToEnvironmentVariables(bool value) &&
+      {
+        return std::move(withAddSecretsToEnvironmentVariables(value));
+      }
+
+      ListSecretOptionsBuilder &withEnvironmentVariableOverwritePolicy(EnvironmentVariableOverwritePolicy value) &
+      {
+        _options._environmentVariableOverwritePolicy = value;
+        return *this;
+      }
+
+      ListSecretOptionsBuilder &&withEnvironmentVariableOverwritePolicy(EnvironmentVariableOverwritePolicy value) &&
       {
-        _options._tagSlugs = values;
+        return std::move(withEnvironmentVariableOverwritePolicy(value));
+      }
+
+      ListSecretOptionsBuilder &withTagSlugs(std::vector<std::string> values) &
+      {
+        _options._tagSlugs = std::move(values);
         return *this;
       }
 
-      ListSecretOptionsBuilder &withExpandSecretReferences(bool value)
+      ListSecretOptionsBuilder &&withTagSlugs(std::vector<std::string> values) &&
+      {
+        return std::move(withTagSlugs(std::move(values)));
+      }
+
+      ListSecretOptionsBuilder &withExpandSecretReferences(bool value) &
       {
         _options._expandSecretReferences = value;
         return *this;
       }
+
+      ListSecretOptionsBuilder &&withExpandSecretReferences(bool value) &&
+      {
+        return std::move(withExpandSecretReferences(value));
+      }
     };
 
     class GetSecretOptionsBuilder
     {
       GetSecretOptions _options;
 
-    public:
-      GetSecretOptionsBuilder() = default;
-
-      GetSecretOptions build()
+      void validate() const
       {
         if (_options._projectId.empty() || _options._environment.empty())
         {
@@ -302,60 +646,106 @@ namespace Infisical
         {
           throw std::invalid_argument("GetSecretOptions: Secret Key cannot be empty");
         }
+      }
+
+    public:
+      GetSecretOptionsBuilder() = default;
+
+      GetSecretOptions build() const &
+      {
+        validate();
         return _options;
       }
 
-      GetSecretOptionsBuilder &withProjectId(const std::string &value)
+      GetSecretOptions build() &&
+      {
+        validate();
+        return std::move(_options);
+      }
+
+      GetSecretOptionsBuilder &withProjectId(std::string value) &
       {
-        _options._projectId = value;
+        _options._projectId = std::move(value);
         return *this;
       }
 
-      GetSecretOptionsBuilder &withSecretKey(const std::string &value)
+      GetSecretOptionsBuilder &&withProjectId(std::string value) &&
+      {
+        return std::move(withProjectId(std::move(value)));
+      }
+
+      GetSecretOptionsBuilder &withSecretKey(std::string value) &
       {
-        _options._secretKey = value;
+        _options._secretKey = std::move(value);
         return *this;
       }
 
-      GetSecretOptionsBuilder &withEnvironment(const std::string &value)
+      GetSecretOptionsBuilder &&withSecretKey(std::string value) &&
       {
-        _options._environment = value;
+        return std::move(withSecretKey(std::move(value)));
+      }
+
+      GetSecretOptionsBuilder &withEnvironment(std::string value) &
+      {
+        _options._environment = std::move(value);
         return *this;
       }
 
-      GetSecretOptionsBuilder &withSecretPath(const std::string &value)
+      GetSecretOptionsBuilder &&withEnvironment(std::string value) &&
+      {
+        return std::move(withEnvironment(std::move(value)));
+      }
+
+      GetSecretOptionsBuilder &withSecretPath(std::string value) &
       {
-        _options._secretPath = value;
+        _options._secretPath = std::move(value);
         return *this;
       }
 
-      GetSecretOptionsBuilder &withVersion(unsigned int value)
+      GetSecretOptionsBuilder &&withSecretPath(std::string value) &&
+      {
+        return std::move(withSecretPath(std::move(value)));
+      }
+
+      GetSecretOptionsBuilder &withVersion(unsigned int value) &
       {
         _options._version = value;
         return *this;
       }
 
-      GetSecretOptionsBuilder &withType(const std::string &value)
+      GetSecretOptionsBuilder &&withVersion(unsigned int value) &&
+      {
+        return std::move(withVersion(value));
+      }
+
+      GetSecretOptionsBuilder &withType(std::string value) &
       {
-        _options._type = value;
+        _options._type = std::move(value);
         return *this;
       }
 
-      GetSecretOptionsBuilder &withExpandSecretReferences(bool value)
+      GetSecretOptionsBuilder &&withType(std::string value) &&
+      {
+        return std::move(withType(std::move(value)));
+      }
+
+      GetSecretOptionsBuilder &withExpandSecretReferences(bool value) &
       {
         _options._expandSecretReferences = value;
         return *this;
       }
+
+      GetSecretOptionsBuilder &&withExpandSecretReferences(bool value) &&
+      {
+        return std::move(withExpandSecretReferences(value));
+      }
     };
 
     class UpdateSecretOptionsBuilder
     {
       UpdateSecretOptions _options;
 
-    public:
-      UpdateSecretOptionsBuilder() = default;
-
-      UpdateSecretOptions build()
+      void validate() const
       {
         if (_options._projectId.empty() || _options._environment.empty())
         {
@@ -365,190 +755,423 @@ namespace Infisical
         {
           throw std::invalid_argument("UpdateSecretOptions: Secret Key cannot be empty");
         }
+      }
+
+    public:
+      UpdateSecretOptionsBuilder() = default;
+
+      UpdateSecretOptions build() const &
+      {
+        validate();
         return _options;
       }
 
-      UpdateSecretOptionsBuilder &withProjectId(const std::string &value)
+      UpdateSecretOptions build() &&
       {
-        _options._projectId = value;
-        return *this;
+        validate();
+        return std::move(_options);
       }
 
-      UpdateSecretOptionsBuilder &withType(const std::string &value)
+      UpdateSecretOptionsBuilder &withProjectId(std::string value) &
       {
-        _options._type = value;
+        _options._projectId = std::move(value);
         return *this;
       }
 
-      UpdateSecretOptionsBuilder &withEnvironment(const std::string &value)
+      UpdateSecretOptionsBuilder &&withProjectId(std::string value) &&
       {
-        _options._environment = value;
-        return *this;
+        return std::move(withProjectId(std::move(value)));
       }
 
-      UpdateSecretOptionsBuilder &withSecretPath(const std::string &value)
+      UpdateSecretOptionsBuilder &withType(std::string value) &
       {
-        _options._secretPath = value;
+        _options._type = std::move(value);
         return *this;
       }
 
-      UpdateSecretOptionsBuilder &withSecretKey(const std::string &value)
+      UpdateSecretOptionsBuilder &&withType(std::string value) &&
       {
-        _options._secretKey = value;
-        return *this;
+        return std::move(withType(std::move(value)));
       }
 
-      UpdateSecretOptionsBuilder &withNewSecretKey(const std::string &value)
+      UpdateSecretOptionsBuilder &withEnvironment(std::string value) &
       {
-        _options._newSecretKey = value;
+        _options._environment = std::move(value);
         return *this;
       }
 
-      UpdateSecretOptionsBuilder &withSecretValue(const std::string &value)
+      UpdateSecretOptionsBuilder &&withEnvironment(std::string value) &&
       {
-        _options._secretValue = value;
-        return *this;
+        return std::move(withEnvironment(std::move(value)));
       }
 
-      UpdateSecretOptionsBuilder &withSecretComment(const std::string &value)
+      UpdateSecretOptionsBuilder &withSecretPath(std::string value) &
       {
-        _options._secretComment = value;
+        _options._secretPath = std::move(value);
         return *this;
       }
 
-      UpdateSecretOptionsBuilder &withSecretReminderNote(const std::string &value)
+      UpdateSecretOptionsBuilder &&withSecretPath(std::string value) &&
       {
-        _options._secretReminderNote = value;
-        return *this;
+        return std::move(withSecretPath(std::move(value)));
       }
 
-      UpdateSecretOptionsBuilder &withSecretReminderRepeatDays(const unsigned int &value)
+      UpdateSecretOptionsBuilder &withSecretKey(std::string value) &
       {
-        _options._secretReminderRepeatDays = value;
+        _options._secretKey = std::move(value);
         return *this;
       }
 
-      UpdateSecretOptionsBuilder &withTagIds(const std::vector<std::string> &values)
+      UpdateSecretOptionsBuilder &&withSecretKey(std::string value) &&
+      {
+        return std::move(withSecretKey(std::move(value)));
+      }
+
+      UpdateSecretOptionsBuilder &withNewSecretKey(std::string value) &
       {
-        _options._tagIds = values;
+        _options._newSecretKey = std::move(value);
         return *this;
       }
-    };
 
-    class CreateSecretOptionsBuilder
-    {
-      CreateSecretOptions _options;
+      UpdateSecretOptionsBuilder &&withNewSecretKey(std::string value) &&
+      {
+        return std::move(withNewSecretKey(std::move(value)));
+      }
 
-    public:
-      CreateSecretOptionsBuilder() = default;
+      UpdateSecretOptionsBuilder &withSecretValue(std::string value) &
+      {
+        _options._secretValue = std::move(value);
+        return *this;
+      }
 
-      CreateSecretOptions build()
+      UpdateSecretOptionsBuilder &&withSecretValue(std::string value) &&
       {
-        if (_options._projectId.empty() || _options._environment.empty())
-        {
-          throw std::invalid_argument("CreateSecretOptions: Project ID and Environment cannot be empty");
-        }
-        if (_options._secretKey.empty())
-        {
-          throw std::invalid_argument("CreateSecretOptions: Secret Key cannot be empty");
-        }
-        return _options;
+        return std::move(withSecretValue(std::move(value)));
       }
 
-      CreateSecretOptionsBuilder &withProjectId(const std::string &value)
+      UpdateSecretOptionsBuilder &withSecretComment(std::string value) &
       {
-        _options._projectId = value;
+        _options._secretComment = std::move(value);
         return *this;
       }
 
-      CreateSecretOptionsBuilder &withSecretComment(const std::string &value)
+      UpdateSecretOptionsBuilder &&withSecretComment(std::string value) &&
       {
-        _options._secretComment = value;
-        return *this;
+        return std::move(withSecretComment(std::move(value)));
       }
 
-      CreateSecretOptionsBuilder &withEnvironment(const std::string &value)
+      UpdateSecretOptionsBuilder &withSecretReminderNote(std::string value) &
       {
-        _options._environment = value;
+        _options._secretReminderNote = std::move(value);
         return *this;
       }
 
-      CreateSecretOptionsBuilder &withSecretPath(const std::string &value)
+      UpdateSecretOptionsBuilder &&withSecretReminderNote(std::string value) &&
       {
-        _options._secretPath = value;
-        return *this;
+        return std::move(withSecretReminderNote(std::move(value)));
       }
 
-      CreateSecretOptionsBuilder &withSecretKey(const std::string &value)
+      UpdateSecretOptionsBuilder &withSecretReminderRepeatDays(unsigned int value) &
       {
-        _options._secretKey = value;
+        _options._secretReminderRepeatDays = value;
         return *this;
       }
 
-      CreateSecretOptionsBuilder &withSecretValue(const std::string &value)
+      UpdateSecretOptionsBuilder &&withSecretReminderRepeatDays(unsigned int value) &&
       {
-        _options._secretValue = value;
-        return *this;
+        return std::move(withSecretReminderRepeatDays(value));
       }
 
-      CreateSecretOptionsBuilder &withTagIds(const std::vector<std::string> &values)
+      UpdateSecretOptionsBuilder &withTagIds(std::vector<std::string> values) &
       {
-        _options._tagIds = values;
+        _options._tagIds = std::move(values);
         return *this;
       }
+
+      UpdateSecretOptionsBuilder &&withTagIds(std::vector<std::string> values) &&
+      {
+        return std::move(withTagIds(std::move(values)));
+      }
     };
 
-    class DeleteSecretOptionsBuilder
+    class CreateSecretOptionsBuilder
     {
-      DeleteSecretOptions _options;
-
-    public:
-      DeleteSecretOptionsBuilder() = default;
+      CreateSecretOptions _options;
 
-      DeleteSecretOptions build()
+      void validate() const
       {
         if (_options._projectId.empty() || _options._environment.empty())
         {
-          throw std::invalid_argument("DeleteSecretOptions: Project ID and Environment cannot be empty");
+          throw std::invalid_argument("CreateSecretOptions: Project ID and Environment cannot be empty");
         }
         if (_options._secretKey.empty())
         {
-          throw std::invalid_argument("DeleteSecretOptions: Secret Name cannot be empty");
+          throw std::invalid_argument("CreateSecretOptions: Secret Key cannot be empty");
         }
+      }
+
+    public:
+      CreateSecretOptionsBuilder() = default;
+
+      CreateSecretOptions build() const &
+      {
+        validate();
         return _options;
       }
 
-      DeleteSecretOptionsBuilder &withProjectId(const std::string &value)
+      CreateSecretOptions build() &&
       {
-        _options._projectId = value;
-        return *this;
+        validate();
+        return std::move(_options);
       }
 
-      DeleteSecretOptionsBuilder &withEnvironment(const std::string &value)
+      CreateSecretOptionsBuilder &withProjectId(std::string value) &
       {
-        _options._environment = value;
+        _options._projectId = std::move(value);
         return *this;
       }
 
-      DeleteSecretOptionsBuilder &withSecretPath(const std::string &value)
+      CreateSecretOptionsBuilder &&withProjectId(std::string value) &&
+      {
+        return std::move(withProjectId(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withSecretComment(std::string value) &
       {
-        _options._secretPath = value;
+        _options._secretComment = std::move(value);
         return *this;
       }
 
-      DeleteSecretOptionsBuilder &withType(const std::string &value)
+      CreateSecretOptionsBuilder &&withSecretComment(std::string value) &&
       {
-        _options._type = value;
+        return std::move(withSecretComment(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withEnvironment(std::string value) &
+      {
+        _options._environment = std::move(value);
         return *this;
       }
 
-      DeleteSecretOptionsBuilder &withSecretKey(const std::string &value)
+      CreateSecretOptionsBuilder &&withEnvironment(std::string value) &&
+      {
+        return std::move(withEnvironment(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withSecretPath(std::string value) &
       {
-        _options._secretKey = value;
+        _options._secretPath = std::move(value);
         return *this;
       }
-    };
-  }
+
+      CreateSecretOptionsBuilder &&withSecretPath(std::string value) &&
+      {
+        return std::move(withSecretPath(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withSecretKey(std::string value) &
+      {
+        _options._secretKey = std::move(value);
+        return *this;
+      }
+
+      CreateSecretOptionsBuilder &&withSecretKey(std::string value) &&
+      {
+        return std::move(withSecretKey(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withSecretValue(std::string value) &
+      {
+        _options._secretValue = std::move(value);
+        return *this;
+      }
+
+      CreateSecretOptionsBuilder &&withSecretValue(std::string value) &&
+      {
+        return std::move(withSecretValue(std::move(value)));
+      }
+
+      CreateSecretOptionsBuilder &withTagIds(std::vector<std::string> values) &
+      {
+        _options._tagIds = std::move(values);
+        return *this;
+      }
+
+      CreateSecretOptionsBuilder &&withTagIds(std::vector<std::string> values) &&
+      {
+        return std::move(withTagIds(std::move(values)));
+      }
+    };
+
+    class DeleteSecretOptionsBuilder
+    {
+      DeleteSecretOptions _options;
+
+      void validate() const
+      {
+        if (_options._projectId.empty() || _options._environment.empty())
+        {
+          throw std::invalid_argument("DeleteSecretOptions: Project ID and Environment cannot be empty");
+        }
+        if (_options._secretKey.empty())
+        {
+          throw std::invalid_argument("DeleteSecretOptions: Secret Name cannot be empty");
+        }
+      }
+
+    public:
+      DeleteSecretOptionsBuilder() = default;
+
+      DeleteSecretOptions build() const &
+      {
+        validate();
+        return _options;
+      }
+
+      DeleteSecretOptions build() &&
+      {
+        validate();
+        return std::move(_options);
+      }
+
+      DeleteSecretOptionsBuilder &withProjectId(std::string value) &
+      {
+        _options._projectId = std::move(value);
+        return *this;
+      }
+
+      DeleteSecretOptionsBuilder &&withProjectId(std::string value) &&
+      {
+        return std::move(withProjectId(std::move(value)));
+      }
+
+      DeleteSecretOptionsBuilder &withEnvironment(std::string value) &
+      {
+        _options._environment = std::move(value);
+        return *this;
+      }
+
+      DeleteSecretOptionsBuilder &&withEnvironment(std::string value) &&
+      {
+        return std::move(withEnvironment(std::move(value)));
+      }
+
+      DeleteSecretOptionsBuilder &withSecretPath(std::string value) &
+      {
+        _options._secretPath = std::move(value);
+        return *this;
+      }
+
+      DeleteSecretOptionsBuilder &&withSecretPath(std::string value) &&
+      {
+        return std::move(withSecretPath(std::move(value)));
+      }
+
+      DeleteSecretOptionsBuilder &withType(std::string value) &
+      {
+        _options._type = std::move(value);
+        return *this;
+      }
+
+      DeleteSecretOptionsBuilder &&withType(std::string value) &&
+      {
+        return std::move(withType(std::move(value)));
+      }
+
+      DeleteSecretOptionsBuilder &withSecretKey(std::string value) &
+      {
+        _options._secretKey = std::move(value);
+        return *this;
+      }
+
+      DeleteSecretOptionsBuilder &&withSecretKey(std::string value) &&
+      {
+        return std::move(withSecretKey(std::move(value)));
+      }
+    };
+
+    class ListSecretVersionsOptions
+    {
+      std::string _secretId;
+      unsigned int _offset = 0;
+      unsigned int _limit = 20;
+
+      friend class ListSecretVersionsOptionsBuilder;
+
+    public:
+      const std::string &getSecretId() const { return _secretId; }
+      unsigned int getOffset() const { return _offset; }
+      unsigned int getLimit() const { return _limit; }
+    };
+
+    class ListSecretVersionsOptionsBuilder
+    {
+      ListSecretVersionsOptions _options;
+
+      void validate() const
+      {
+        if (_options._secretId.empty())
+        {
+          throw std::invalid_argument("ListSecretVersionsOptions: Secret ID cannot be empty");
+        }
+        if (_options._limit == 0)
+        {
+          throw std::invalid_argument("ListSecretVersionsOptions: Limit must be at least 1");
+        }
+      }
+
+    public:
+      ListSecretVersionsOptionsBuilder() = default;
+
+      ListSecretVersionsOptions build() const &
+      {
+        validate();
+        return _options;
+      }
+
+      ListSecretVersionsOptions build() &&
+      {
+        validate();
+        return std::move(_options);
+      }
+
+      /**
+       * ID of the secret, as returned by `TSecret::getId()`
+       */
+      ListSecretVersionsOptionsBuilder &withSecretId(std::string value) &
+      {
+        _options._secretId = std::move(value);
+        return *this;
+      }
+
+      ListSecretVersionsOptionsBuilder &&withSecretId(std::string value) &&
+      {
+        return std::move(withSecretId(std::move(value)));
+      }
+
+      ListSecretVersionsOptionsBuilder &withOffset(unsigned int value) &
+      {
+        _options._offset = value;
+        return *this;
+      }
+
+      ListSecretVersionsOptionsBuilder &&withOffset(unsigned int value) &&
+      {
+        return std::move(withOffset(value));
+      }
+
+      ListSecretVersionsOptionsBuilder &withLimit(unsigned int value) &
+      {
+        _options._limit = value;
+        return *this;
+      }
+
+      ListSecretVersionsOptionsBuilder &&withLimit(unsigned int value) &&
+      {
+        return std::move(withLimit(value));
+      }
+    };
+  }
 
   namespace Secrets
   {
@@ -557,6 +1180,8 @@ namespace Infisical
       std::string key;
       std::string value;
 
+      friend class SecretView;
+
     public:
       const std::string &getKey() const { return key; }
       const std::string &getValue() const { return value; }
@@ -572,33 +1197,73 @@ namespace Infisical
       unsigned int version;
       std::string type;
       std::string secretKey;
-      std::string secretValue;
+      SecretString secretValue;
       std::string secretPath;
       bool skipMultilineEncoding;
       bool isRotatedSecret;
       std::optional<std::string> rotationId;
       std::vector<SecretMetadata> secretMetadata;
 
+      friend class SecretView;
+
     public:
+      TSecret() = default;
+      TSecret(const TSecret &) = default;
+      TSecret(TSecret &&) = default;
+      TSecret &operator=(const TSecret &other) { return *this = TSecret(other); }
+
+      // a short value lives inside the string object, a defaulted assignment that brings a heap buffer would leave it there
+      TSecret &operator=(TSecret &&other) noexcept
+      {
+        if (this != &other)
+        {
+          secure::wipe(secretValue);
+          id = std::move(other.id);
+          workspace = std::move(other.workspace);
+          environment = std::move(other.environment);
+          version = other.version;
+          type = std::move(other.type);
+          secretKey = std::move(other.secretKey);
+          secretValue = std::move(other.secretValue);
+          secretPath = std::move(other.secretPath);
+          skipMultilineEncoding = other.skipMultilineEncoding;
+          isRotatedSecret = other.isRotatedSecret;
+          rotationId = std::move(other.rotationId);
+          secretMetadata = std::move(other.secretMetadata);
+          secure::wipe(other.secretValue);
+        }
+        return *this;
+      }
+
+      // don't leave the value behind in freed memory
+      ~TSecret() { secure::wipe(secretValue); }
+
       const std::string &getId() const { return id; }
       const std::string &getWorkspace() const { return workspace; }
       const std::string &getEnvironment() const { return environment; }
       unsigned int getVersion() const { return version; }
       const std::string &getType() const { return type; }
       const std::string &getSecretKey() const { return secretKey; }
-      const std::string &getSecretValue() const { return secretValue; }
+      const SecretString &getSecretValue() const { return secretValue; }
       const std::string &getRotationId() const
 
       {
         static const std::string empty;
         return rotationId ? *rotationId : empty;
       }
+      bool hasRotationId() const { return rotationId.has_value(); }
 
       void _setSecretPath(const std::string &path)
       {
         secretPath = path;
       }
 
+      void _setSecretValue(SecretString value)
+      {
+        secure::wipe(secretValue);
+        secretValue = std::move(value);
+      }
+
       const std::string &getSecretPath() const { return secretPath; }
       bool getSkipMultilineEncoding() const { return skipMultilineEncoding; }
       bool getIsRotatedSecret() const { return isRotatedSecret; }
@@ -614,7 +1279,8 @@ namespace Infisical
         j.at("version").get_to(secret.version);
         j.at("type").get_to(secret.type);
         j.at("secretKey").get_to(secret.secretKey);
-        j.at("secretValue").get_to(secret.secretValue);
+        const auto &secretValue = j.at("secretValue").get_ref<const std::string &>();
+        secret.secretValue.assign(secretValue.data(), secretValue.size());
         j.at("skipMultilineEncoding").get_to(secret.skipMultilineEncoding);
 
         // Optional fields
@@ -669,21 +1335,858 @@ namespace Infisical
       const std::string &getFolderId() const { return folderId; }
       const std::vector<TSecret> &getSecrets() const { return secrets; }
 
-      NLOHMANN_DEFINE_TYPE_INTRUSIVE(TImports, secretPath, environment, folderId, secrets)
-    };
+      NLOHMANN_DEFINE_TYPE_INTRUSIVE(TImports, secretPath, environment, folderId, secrets)
+    };
+
+    /**
+     * One entry of a secret's version history. A version never changes once it's written.
+     */
+    class SecretVersion
+    {
+      std::string id;
+      std::string secretId;
+      unsigned int version = 0;
+      std::string type;
+      std::string secretKey;
+      SecretString secretValue;
+      std::string secretComment;
+      std::string createdAt;
+
+    public:
+      SecretVersion() = default;
+      SecretVersion(const SecretVersion &) = default;
+      SecretVersion(SecretVersion &&) = default;
+      SecretVersion &operator=(const SecretVersion &other) { return *this = SecretVersion(other); }
+
+      // wipes the replaced value first, same as TSecret
+      SecretVersion &operator=(SecretVersion &&other) noexcept
+      {
+        if (this != &other)
+        {
+          secure::wipe(secretValue);
+          id = std::move(other.id);
+          secretId = std::move(other.secretId);
+          version = other.version;
+          type = std::move(other.type);
+          secretKey = std::move(other.secretKey);
+          secretValue = std::move(other.secretValue);
+          secretComment = std::move(other.secretComment);
+          createdAt = std::move(other.createdAt);
+          secure::wipe(other.secretValue);
+        }
+        return *this;
+      }
+
+      ~SecretVersion() { secure::wipe(secretValue); }
+
+      const std::string &getId() const { return id; }
+      const std::string &getSecretId() const { return secretId; }
+      unsigned int getVersion() const { return version; }
+      const std::string &getType() const { return type; }
+      const std::string &getSecretKey() const { return secretKey; }
+      const SecretString &getSecretValue() const { return secretValue; }
+      const std::string &getSecretComment() const { return secretComment; }
+      const std::string &getCreatedAt() const { return createdAt; }
+
+      friend void from_json(const nlohmann::json &j, SecretVersion &secretVersion)
+      {
+        j.at("id").get_to(secretVersion.id);
+        j.at("version").get_to(secretVersion.version);
+        j.at("secretKey").get_to(secretVersion.secretKey);
+
+        // older servers leave out some of these
+        secretVersion.secretId = j.value("secretId", "");
+        secretVersion.type = j.value("type", "shared");
+        secretVersion.secretComment = j.contains("secretComment") && j.at("secretComment").is_string() ? j.at("secretComment").get<std::string>() : "";
+        secretVersion.createdAt = j.value("createdAt", "");
+
+        secure::wipe(secretVersion.secretValue);
+        if (j.contains("secretValue") && j.at("secretValue").is_string())
+        {
+          const auto &secretValue = j.at("secretValue").get_ref<const std::string &>();
+          secretVersion.secretValue.assign(secretValue.data(), secretValue.size());
+        }
+      }
+    };
+
+    /**
+     * Read-only view of a secret stored inside a SecretSnapshot.
+     * All fields point directly into the mapped snapshot file, so a view is only valid for as long as the snapshot it came from is open.
+     */
+    class SecretView
+    {
+      std::string_view id;
+      std::string_view workspace;
+      std::string_view environment;
+      unsigned int version = 0;
+      std::string_view type;
+      std::string_view secretKey;
+      std::string_view secretValue;
+      std::string_view secretPath;
+      std::string_view rotationId;
+      std::string_view secretMetadata;
+      bool skipMultilineEncoding = false;
+      bool isRotatedSecret = false;
+      bool hasRotationId = false;
+
+      friend class SecretSnapshot;
+
+    public:
+      std::string_view getId() const { return id; }
+      std::string_view getWorkspace() const { return workspace; }
+      std::string_view getEnvironment() const { return environment; }
+      unsigned int getVersion() const { return version; }
+      std::string_view getType() const { return type; }
+      std::string_view getSecretKey() const { return secretKey; }
+      std::string_view getSecretValue() const { return secretValue; }
+      std::string_view getSecretPath() const { return secretPath; }
+      bool getSkipMultilineEncoding() const { return skipMultilineEncoding; }
+      bool getIsRotatedSecret() const { return isRotatedSecret; }
+      std::string_view getRotationId() const { return rotationId; }
+
+      /**
+       * Decoded from the snapshot on every call.
+       */
+      std::vector<SecretMetadata> getSecretMetadata() const;
+
+      /**
+       * Copy the viewed secret into an owning `TSecret`, including its rotation ID and metadata.
+       */
+      TSecret toSecret() const;
+    };
+
+    /**
+     * Compact binary snapshot of a secret set that can be shared between processes.
+     *
+     * One process (or a sidecar) writes the snapshot with `SecretSnapshot::write()`, and any number of processes map it read-only with `SecretSnapshot::open()`.
+     * Lookups binary search a key-sorted, offset-indexed entry table and return `SecretView`s that point straight into the mapping, so readers do no parsing and no heap copies.
+     */
+    class SecretSnapshot
+    {
+    public:
+      /**
+       * Atomically write a snapshot of `secrets` to `path`.
+       * The file is written next to `path` and renamed into place, so readers that already have the previous snapshot mapped are unaffected.
+       * If the same key occurs more than once, the last occurrence wins.
+       */
+      static void write(const std::string &path, const std::vector<TSecret> &secrets);
+
+      /**
+       * Map an existing snapshot read-only. Throws an `InfisicalError` if the file is missing or is not a valid snapshot.
+       */
+      static SecretSnapshot open(const std::string &path);
+
+      /**
+       * Serialize `secrets` into the snapshot format without writing it anywhere, e.g. to send it over a socket.
+       */
+      static SecretString serialize(const std::vector<TSecret> &secrets);
+
+      /**
+       * Take ownership of a serialized snapshot held in memory. Validated the same way as `open()`.
+       */
+      static SecretSnapshot fromBuffer(SecretString buffer);
+
+      SecretSnapshot(SecretSnapshot &&other) noexcept;
+      SecretSnapshot &operator=(SecretSnapshot &&other) noexcept;
+      SecretSnapshot(const SecretSnapshot &) = delete;
+      SecretSnapshot &operator=(const SecretSnapshot &) = delete;
+      ~SecretSnapshot();
+
+      std::optional<SecretView> find(std::string_view secretKey) const;
+      SecretView at(size_t index) const;
+      size_t size() const { return _count; }
+
+    private:
+      SecretSnapshot() = default;
+      void validate(const std::string &source);
+      void close();
+
+      const char *_data = nullptr;
+      size_t _size = 0;
+      uint32_t _count = 0;
+      bool _mapped = false;
+      SecretString _buffer;
+    };
+
+    class CompactSecretList;
+
+    /**
+     * Lightweight view of a secret stored in a CompactSecretList. Only valid for as long as the list it came from.
+     */
+    class CompactSecret
+    {
+      const CompactSecretList *list;
+      uint32_t index;
+
+      friend class CompactSecretList;
+      CompactSecret(const CompactSecretList *list, uint32_t index) : list(list), index(index) {}
+
+    public:
+      std::string_view getId() const;
+      std::string_view getWorkspace() const;
+      std::string_view getEnvironment() const;
+      unsigned int getVersion() const;
+      std::string_view getType() const;
+      std::string_view getSecretKey() const;
+      std::string_view getSecretValue() const;
+      std::string_view getSecretPath() const;
+      std::string_view getRotationId() const;
+      bool getSkipMultilineEncoding() const;
+      bool getIsRotatedSecret() const;
+    };
+
+    /**
+     * Memory-compact alternative to `std::vector<TSecret>` for large listings.
+     *
+     * Ids, keys and values are stored back to back in a single arena owned by the list, and the workspace, environment, type and secret path (which repeat across nearly every secret) are interned and stored once.
+     * Each secret costs one fixed-size record instead of eight or more separately allocated strings. Secret metadata is not kept.
+     */
+    class CompactSecretList
+    {
+    public:
+      CompactSecretList() = default;
+
+      static CompactSecretList fromSecrets(const std::vector<TSecret> &secrets);
+
+      size_t size() const { return _records.size(); }
+      bool empty() const { return _records.empty(); }
+      CompactSecret operator[](size_t index) const { return CompactSecret(this, static_cast<uint32_t>(index)); }
+      std::optional<CompactSecret> find(std::string_view secretKey) const;
+
+      /**
+       * Approximate heap bytes held by the list, useful for comparing against the equivalent `std::vector<TSecret>`.
+       */
+      size_t getMemoryUsage() const;
+
+    private:
+      friend class CompactSecret;
+      friend class SecretsClient;
+
+      struct Span
+      {
+        uint32_t offset;
+        uint32_t length;
+      };
+
+      struct Record
+      {
+        Span id;
+        Span secretKey;
+        Span secretValue;
+        Span rotationId;
+        uint32_t workspace;
+        uint32_t environment;
+        uint32_t type;
+        uint32_t secretPath;
+        uint32_t version;
+        uint32_t flags;
+      };
+
+      class Builder;
+
+      static CompactSecretList fromListResponse(const nlohmann::json &response, bool uniqueByKey);
+
+      std::string_view span(Span s) const { return std::string_view(_arena.data() + s.offset, s.length); }
+
+      std::string _arena;
+      std::vector<std::string> _interned;
+      std::vector<Record> _records;
+      std::vector<uint32_t> _sortedIndex;
+    };
+
+    /**
+     * A complete environment (`KEY=VALUE` strings plus a null-terminated pointer array) built in one pass, ready to hand to `execve()`.
+     *
+     * Building the block never touches the process environment, so unlike `withAddSecretsToEnvironmentVariables` it doesn't race with threads reading it, and it costs one allocation for the whole block instead of one `setenv` per secret.
+     */
+    class EnvironmentBlock
+    {
+    public:
+      /**
+       * @param secrets Secrets to export, keyed by secret key. If a key occurs more than once the last occurrence wins.
+       * @param policy Whether secrets replace variables already present in the inherited environment.
+       * @param inheritCurrentEnvironment Start from a copy of the current process environment instead of an empty one.
+       */
+      static EnvironmentBlock fromSecrets(
+          const std::vector<TSecret> &secrets,
+          Input::EnvironmentVariableOverwritePolicy policy = Input::EnvironmentVariableOverwritePolicy::SKIP_EXISTING,
+          bool inheritCurrentEnvironment = true);
+
+      static EnvironmentBlock fromSecrets(
+          const CompactSecretList &secrets,
+          Input::EnvironmentVariableOverwritePolicy policy = Input::EnvironmentVariableOverwritePolicy::SKIP_EXISTING,
+          bool inheritCurrentEnvironment = true);
+
+      EnvironmentBlock(EnvironmentBlock &&) = default;
+
+      // the replaced block's secrets are wiped before its buffer is freed, same as in the destructor
+      EnvironmentBlock &operator=(EnvironmentBlock &&other) noexcept
+      {
+        if (this != &other)
+        {
+          secure::wipe(_buffer.data(), _buffer.size());
+          _buffer = std::move(other._buffer);
+          _pointers = std::move(other._pointers);
+        }
+        return *this;
+      }
+      EnvironmentBlock(const EnvironmentBlock &) = delete;
+      EnvironmentBlock &operator=(const EnvironmentBlock &) = delete;
+      ~EnvironmentBlock() { secure::wipe(_buffer.data(), _buffer.size()); }
+
+      /**
+       * Null-terminated `KEY=VALUE` array for `execve()`/`posix_spawn()`. Valid for as long as the block.
+       */
+      char *const *envp() const { return _pointers.data(); }
+      size_t size() const { return _pointers.size() - 1; }
+
+    private:
+      class Builder;
+
+      EnvironmentBlock() = default;
+
+      // a vector rather than a string, so moving the block never relocates the bytes _pointers refers to
+      std::vector<char, SecretString::allocator_type> _buffer;
+      std::vector<char *> _pointers;
+    };
+
+    struct LazySecretState;
+
+    /**
+     * Handle to a secret from `listSecretsLazy()`. Key, version and metadata are available right away; the value is fetched on first access and memoized.
+     * Handles keep the listing alive, but the `InfisicalClient` they came from must outlive them.
+     */
+    class LazySecret
+    {
+      std::shared_ptr<LazySecretState> state;
+      size_t index;
+
+      friend class LazySecretList;
+      LazySecret(std::shared_ptr<LazySecretState> state, size_t index) : state(std::move(state)), index(index) {}
+
+    public:
+      const std::string &getId() const;
+      const std::string &getWorkspace() const;
+      const std::string &getEnvironment() const;
+      unsigned int getVersion() const;
+      const std::string &getType() const;
+      const std::string &getSecretKey() const;
+      const std::string &getSecretPath() const;
+      const std::vector<SecretMetadata> &getSecretMetadata() const;
+
+      bool isValueLoaded() const;
+
+      /**
+       * Returns the secret value, fetching it from Infisical on first access.
+       */
+      const SecretString &getSecretValue() const;
+    };
+
+    /**
+     * Result of `listSecretsLazy()`: secret keys, versions and metadata without values.
+     */
+    class LazySecretList
+    {
+      std::shared_ptr<LazySecretState> state;
+
+      friend class SecretsClient;
+      explicit LazySecretList(std::shared_ptr<LazySecretState> state) : state(std::move(state)) {}
+
+      static LazySecretList fromListing(SecretsClient *client, Input::ListSecretsOptions options, std::vector<TSecret> secrets);
+
+    public:
+      size_t size() const;
+      LazySecret operator[](size_t index) const { return LazySecret(state, index); }
+      std::optional<LazySecret> find(const std::string &secretKey) const;
+
+      /**
+       * Load the values of several secrets at once. Small sets are fetched one by one, larger ones with a single listing request, so touching many values costs one round trip instead of one per secret.
+       */
+      void prefetch(const std::vector<std::string> &secretKeys) const;
+
+      /**
+       * Load all values with a single listing request.
+       */
+      void prefetchAll() const;
+    };
+
+    /**
+     * Identifies a secret by environment, folder and key.
+     */
+    struct SecretLocation
+    {
+      std::string environment;
+      std::string secretPath;
+      std::string secretKey;
+    };
+
+    /**
+     * Expands secret references locally, so secrets can be fetched once with `withExpandSecretReferences(false)` and expanded on the client.
+     *
+     * Supports `${KEY}` (same environment and folder) and `${env.folder.subfolder.KEY}` (`${env.KEY}` refers to the root folder of `env`).
+     * References form a dependency graph: expanded values are memoized, cycles and chains more than 64 references deep are reported as errors, and updating a secret only invalidates the secrets that (transitively) reference it.
+     * Secrets from other environments or folders must be added before anything referencing them is expanded.
+     *
+     * Not thread-safe, guard it externally if it's shared between threads.
+     */
+    class SecretReferenceExpander
+    {
+    public:
+      /**
+       * Add (or replace) raw, unexpanded secrets. Secrets without a secret path are placed in `defaultSecretPath`.
+       * @return The secrets whose expansion changed as a result, including the added secrets themselves.
+       */
+      std::vector<SecretLocation> addSecrets(const std::vector<TSecret> &secrets, const std::string &defaultSecretPath = "/");
+
+      /**
+       * Add or replace a single raw value.
+       * @return The secrets whose expansion changed as a result, including the secret itself.
+       */
+      std::vector<SecretLocation> setSecret(const std::string &environment, const std::string &secretPath, const std::string &secretKey, std::string_view rawValue);
+
+      /**
+       * Remove a secret. Secrets referencing it will fail to expand until it is added again.
+       * @return The secrets whose expansion changed as a result.
+       */
+      std::vector<SecretLocation> removeSecret(const std::string &environment, const std::string &secretPath, const std::string &secretKey);
+
+      /**
+       * Expanded value of a secret. Throws an `InfisicalError` if the secret or one of its references is unknown, or if the references form a cycle.
+       */
+      const SecretString &expand(const std::string &environment, const std::string &secretPath, const std::string &secretKey);
+
+      /**
+       * Add `secrets` (see `addSecrets()`) and return copies of them with their values expanded.
+       */
+      std::vector<TSecret> expand(const std::vector<TSecret> &secrets, const std::string &defaultSecretPath = "/");
+
+    private:
+      struct Node
+      {
+        SecretLocation location;
+        bool present = false;
+        SecretString rawValue;
+        std::optional<SecretString> expanded;
+        std::vector<std::string> dependencies;
+        std::vector<std::string> dependents;
+      };
+
+      Node &node(const std::string &id, const SecretLocation &location);
+      const SecretString &expandNode(const std::string &id, std::vector<std::string> &stack);
+      void invalidate(const std::string &id, std::vector<SecretLocation> &changed);
+      void unlinkDependencies(const std::string &id, Node &n);
+
+      std::unordered_map<std::string, Node> _nodes;
+    };
+
+    /**
+     * Differences between two listings of the same scope.
+     */
+    struct SecretChangeSet
+    {
+      std::vector<TSecret> added;
+      std::vector<TSecret> removed;
+      // the new state of secrets whose version or value changed
+      std::vector<TSecret> modified;
+
+      bool empty() const { return added.empty() && removed.empty() && modified.empty(); }
+    };
+
+    /**
+     * Compute what changed between two listings in linear time.
+     * Secrets are matched by key, type and secret path, and count as modified when their version changed. The value is compared as well, because with server-side reference expansion a value can change without its own version changing.
+     */
+    SecretChangeSet diffSecrets(const std::vector<TSecret> &previous, const std::vector<TSecret> &current);
+
+    class SecretsClient
+    {
+      friend struct LazySecretState;
+
+      http::HttpClient *httpClient;
+      auth::AuthClient *authClient;
+      agent::AgentClient *agentClient;
+
+      std::chrono::milliseconds missingSecretTtl{0};
+      std::mutex missingSecretsMutex;
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point> missingSecrets;
+      uint64_t missingSecretsGeneration = 0;
+
+      // versions never change, so neither of these expires. versionedSecrets is keyed by name, which a deleted and recreated secret
+      // reuses from version 1, so deleting, creating or renaming a secret through this client drops the entries for its name
+      std::mutex versionsMutex;
+      std::unordered_map<std::string, SecretVersion> secretVersions;
+      std::unordered_map<std::string, TSecret> versionedSecrets;
+
+      std::vector<TSecret> fetchSecrets(const Input::ListSecretsOptions &options, bool viewSecretValue);
+      Result<TSecret> fetchSecret(const Input::GetSecretOptions &options);
+      void awaitAuthentication();
+      void forgetMissingSecrets();
+      void forgetVersionedSecrets(const std::string &projectId, const std::string &environment, const std::string &secretPath, const std::string &secretKey);
+      void rememberVersionedSecret(const Input::GetSecretOptions &options, const TSecret &secret);
+
+    public:
+      explicit SecretsClient(http::HttpClient *httpClient, auth::AuthClient *authClient = nullptr, agent::AgentClient *agentClient = nullptr);
+
+      std::vector<TSecret> listSecrets(const Input::ListSecretsOptions &options);
+
+      /**
+       * List secrets from several environments/paths concurrently over pooled connections and merge them into one list.
+       * When a key exists in more than one scope, the secret from the scope that comes later in `scopes` wins. Environment variables are set according to the options of the winning scope.
+       */
+      std::vector<TSecret> listSecretsMulti(const std::vector<Input::ListSecretsOptions> &scopes);
+      CompactSecretList listSecretsCompact(const Input::ListSecretsOptions &options);
+      LazySecretList listSecretsLazy(const Input::ListSecretsOptions &options);
+
+      /**
+       * List secrets and diff them against `snapshot`, the result of a previous listing. `snapshot` is replaced with the new listing, so it can be passed back in on the next reload.
+       */
+      SecretChangeSet listSecretChanges(const Input::ListSecretsOptions &options, std::vector<TSecret> &snapshot);
+      /**
+       * Every secret fetched is also kept under its version number, without a TTL, so a later read with `withVersion()` for that version doesn't go to the server.
+       * Values with secret references that are being expanded aren't kept, the secrets they refer to can change.
+       */
+      TSecret getSecret(const Input::GetSecretOptions &options);
+
+      /**
+       * Like `getSecret()`, but a secret that doesn't exist is returned as `std::nullopt` instead of thrown. Other errors are still thrown.
+       * While a missing-secret TTL is set, a miss is remembered for that long and looking the same secret up again returns `std::nullopt` without a request.
+       * Creating or updating a secret through this client forgets all remembered misses.
+       */
+      std::optional<TSecret> tryGetSecret(const Input::GetSecretOptions &options);
+
+      /**
+       * How long `tryGetSecret()` remembers misses. Zero, the default, disables the cache.
+       */
+      void setMissingSecretCacheTtl(std::chrono::milliseconds ttl);
+
+      /**
+       * The version history of a secret, newest first. Every version returned is also kept in the client's version cache.
+       */
+      std::vector<SecretVersion> listSecretVersions(const Input::ListSecretVersionsOptions &options);
+
+      /**
+       * One version of a secret. Served from the version cache when it was fetched before, otherwise the history is paged through until it's found.
+       * Returns `std::nullopt` if the secret has no such version.
+       */
+      std::optional<SecretVersion> getSecretVersion(const std::string &secretId, unsigned int version);
+
+      void prepareFork();
+      void afterForkInParent();
+      void afterForkInChild();
+
+      TSecret updateSecret(const Input::UpdateSecretOptions &options);
+      TSecret createSecret(const Input::CreateSecretOptions &options);
+      TSecret deleteSecret(const Input::DeleteSecretOptions &options);
+    };
+
+    /**
+     * FNV-1a hash of a secret key, usable at compile time.
+     */
+    constexpr uint64_t secretKeyHash(std::string_view key)
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      for (char c : key)
+      {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+
+    template <typename T>
+    struct IsDuration : std::false_type
+    {
+    };
+
+    template <typename Rep, typename Period>
+    struct IsDuration<std::chrono::duration<Rep, Period>> : std::true_type
+    {
+    };
+
+    /**
+     * Compile-time descriptor of a secret key and the type its value is read as.
+     * `T` is `std::string` (the raw value), `bool`, an integer type, a `std::chrono::duration` or `nlohmann::json` (for values holding a JSON object or array).
+     *
+     *   constexpr Infisical::Secrets::SecretKey<int> DB_PORT{"DB_PORT"};
+     */
+    template <typename T = std::string>
+    class SecretKey
+    {
+      static_assert(std::is_same<T, std::string>::value || std::is_same<T, bool>::value || std::is_integral<T>::value || IsDuration<T>::value ||
+                        std::is_same<T, nlohmann::json>::value,
+                    "SecretKey value type must be std::string, bool, an integer type, a std::chrono::duration or nlohmann::json");
+
+    public:
+      constexpr explicit SecretKey(std::string_view name) : _name(name), _hash(secretKeyHash(name)) {}
+
+      constexpr std::string_view name() const { return _name; }
+      constexpr uint64_t hash() const { return _hash; }
+
+    private:
+      std::string_view _name;
+      uint64_t _hash;
+    };
+
+    /**
+     * Secrets of one listing, indexed by precomputed key hash.
+     * `get()` with a `SecretKey` is a single probe into an open-addressing table and never allocates. Integer, boolean, duration and JSON forms of every value are parsed once per `refresh()`.
+     * Keys declared with `expect()` are checked when the secrets are fetched, so a malformed value fails the refresh instead of every read.
+     *
+     * `refresh()` replaces the contents and invalidates references returned by `get()`. It must not run concurrently with reads.
+     */
+    class SecretCache
+    {
+    public:
+      SecretCache(SecretsClient &client, Input::ListSecretsOptions options);
+
+      /**
+       * List the secrets again and rebuild the cache.
+       */
+      void refresh();
+
+      /**
+       * Rebuild the cache from secrets that were fetched elsewhere.
+       */
+      void assign(const std::vector<TSecret> &secrets);
+
+      size_t size() const { return _entries.size(); }
+
+      /**
+       * Require `key` to be present and readable as `T` from now on. A `refresh()` or `assign()` that breaks any expectation throws an `InfisicalError`
+       * naming every offending key and keeps the previous contents, so `get()` on an expected key can't fail on a value that was accepted.
+       */
+      template <typename T>
+      SecretCache &expect(const SecretKey<T> &key)
+      {
+        Expectation expectation{std::string(key.name()), key.hash(), ValueKind::STRING, 0, 0};
+        if constexpr (std::is_same<T, bool>::value)
+        {
+          expectation.kind = ValueKind::BOOLEAN;
+        }
+        else if constexpr (std::is_integral<T>::value)
+        {
+          expectation.kind = ValueKind::INTEGER;
+          expectation.min = static_cast<int64_t>(std::numeric_limits<T>::min());
+          expectation.max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+        }
+        else if constexpr (IsDuration<T>::value)
+        {
+          expectation.kind = ValueKind::DURATION;
+          expectation.accepts = [](const Entry &entry) { return durationAs<T>(entry).has_value(); };
+        }
+        else if constexpr (std::is_same<T, nlohmann::json>::value)
+        {
+          expectation.kind = ValueKind::JSON;
+        }
+        _expectations.push_back(std::move(expectation));
+        return *this;
+      }
+
+      template <typename T>
+      bool contains(const SecretKey<T> &key) const
+      {
+        return lookup(key.name(), key.hash()) != nullptr;
+      }
+
+      /**
+       * Value of `key` as `T`. Throws an `InfisicalError` if the key isn't cached or its value isn't a valid `T`.
+       */
+      const SecretString &get(const SecretKey<std::string> &key) const
+      {
+        return require(key.name(), key.hash()).value;
+      }
+
+      const nlohmann::json &get(const SecretKey<nlohmann::json> &key) const
+      {
+        const auto &entry = require(key.name(), key.hash());
+        if (!entry.json)
+        {
+          throwConversionError(key.name(), "a JSON object or array");
+        }
+        return *entry.json;
+      }
+
+      template <typename T>
+      T get(const SecretKey<T> &key) const
+      {
+        const auto &entry = require(key.name(), key.hash());
+        if constexpr (std::is_same<T, bool>::value)
+        {
+          if (!entry.boolean)
+          {
+            throwConversionError(key.name(), "a boolean");
+          }
+          return *entry.boolean;
+        }
+        else if constexpr (std::is_integral<T>::value)
+        {
+          if (!inRange(entry, static_cast<int64_t>(std::numeric_limits<T>::min()), static_cast<uint64_t>(std::numeric_limits<T>::max())))
+          {
+            throwConversionError(key.name(), "an integer in range");
+          }
+          return static_cast<T>(*entry.integer);
+        }
+        else
+        {
+          auto value = durationAs<T>(entry);
+          if (!value)
+          {
+            throwConversionError(key.name(), "a duration exactly representable in the requested type");
+          }
+          return *value;
+        }
+      }
+
+      /**
+       * Value of the secret called `name` as `T`, e.g. `as<int>("MAX_CONNS")`. Same as `get()` with a `SecretKey<T>`, but the name is hashed on every call.
+       */
+      template <typename T>
+      decltype(auto) as(std::string_view name) const
+      {
+        return get(SecretKey<T>(name));
+      }
+
+    private:
+      enum class ValueKind : uint8_t
+      {
+        STRING,
+        INTEGER,
+        BOOLEAN,
+        DURATION,
+        JSON
+      };
+
+      struct Entry
+      {
+        std::string key;
+        SecretString value;
+        std::optional<int64_t> integer;
+        std::optional<bool> boolean;
+        std::optional<std::chrono::milliseconds> duration;
+        std::optional<nlohmann::json> json;
+
+        Entry() = default;
+        Entry(Entry &&) = default;
+
+        // the parsed forms hold the value too
+        Entry &operator=(Entry &&other) noexcept
+        {
+          if (this != &other)
+          {
+            wipeValue();
+            key = std::move(other.key);
+            value = std::move(other.value);
+            integer = other.integer;
+            boolean = other.boolean;
+            duration = other.duration;
+            json = std::move(other.json);
+            other.wipeValue();
+          }
+          return *this;
+        }
+
+        ~Entry() { wipeValue(); }
+
+        void wipeValue()
+        {
+          secure::wipe(value);
+          if (json)
+          {
+            secure::wipe(*json);
+          }
+          if (integer)
+          {
+            secure::wipe(&*integer, sizeof(*integer));
+          }
+          if (duration)
+          {
+            secure::wipe(&*duration, sizeof(*duration));
+          }
+        }
+      };
+
+      struct Expectation
+      {
+        std::string name;
+        uint64_t hash;
+        ValueKind kind;
+        int64_t min;
+        uint64_t max;
+        // durations, whether the value converts exactly to the expected type
+        bool (*accepts)(const Entry &) = nullptr;
+      };
+
+      struct Slot
+      {
+        uint64_t hash;
+        uint32_t index; // into _entries, UINT32_MAX when empty
+      };
+
+      const Entry *lookup(std::string_view name, uint64_t hash) const;
+      const Entry &require(std::string_view name, uint64_t hash) const;
+      [[noreturn]] static void throwConversionError(std::string_view name, const char *expected);
+      std::string unmetExpectations() const;
+
+      template <typename T>
+      static uint64_t maxCount()
+      {
+        using Rep = typename T::rep;
+        if constexpr (std::is_floating_point<Rep>::value)
+        {
+          return std::numeric_limits<uint64_t>::max();
+        }
+        else
+        {
+          return static_cast<uint64_t>(std::numeric_limits<Rep>::max());
+        }
+      }
+
+      static bool inRange(const Entry &entry, int64_t min, uint64_t max)
+      {
+        return entry.integer && *entry.integer >= min && (*entry.integer < 0 || static_cast<uint64_t>(*entry.integer) <= max);
+      }
 
-    class SecretsClient
-    {
-      http::HttpClient *httpClient;
+      // Like inRange() for integers: "1500ms" isn't a whole number of seconds and "1d" doesn't fit std::chrono::duration<int16_t>, so neither
+      // converts instead of being truncated or wrapped. A plain number counts T's own unit, so SecretKey<std::chrono::milliseconds> reads "500" as 500ms.
+      template <typename T>
+      static std::optional<T> durationAs(const Entry &entry)
+      {
+        using Rep = typename T::rep;
+        if (!entry.duration)
+        {
+          if (!inRange(entry, 0, maxCount<T>()))
+          {
+            return std::nullopt;
+          }
+          return T(static_cast<Rep>(*entry.integer));
+        }
 
-    public:
-      explicit SecretsClient(http::HttpClient *httpClient);
+        if constexpr (std::is_floating_point<Rep>::value)
+        {
+          return std::chrono::duration_cast<T>(*entry.duration);
+        }
+        else
+        {
+          using Scale = std::ratio_divide<std::milli, typename T::period>;
+          const int64_t milliseconds = entry.duration->count();
+          if (milliseconds > std::numeric_limits<int64_t>::max() / Scale::num)
+          {
+            return std::nullopt;
+          }
+          const int64_t scaled = milliseconds * Scale::num;
+          if (scaled % Scale::den != 0 || static_cast<uint64_t>(scaled / Scale::den) > maxCount<T>())
+          {
+            return std::nullopt;
+          }
+          return T(static_cast<Rep>(scaled / Scale::den));
+        }
+      }
 
-      std::vector<TSecret> listSecrets(Input::ListSecretsOptions options);
-      TSecret getSecret(Input::GetSecretOptions options);
-      TSecret updateSecret(Input::UpdateSecretOptions options);
-      TSecret createSecret(Input::CreateSecretOptions options);
-      TSecret deleteSecret(Input::DeleteSecretOptions options);
+      SecretsClient *_client;
+      Input::ListSecretsOptions _options;
+      std::vector<Entry> _entries;
+      std::vector<Slot> _slots;
+      std::vector<Expectation> _expectations;
     };
   }
 
@@ -709,14 +2212,149 @@ namespace Infisical
       DELETE
     };
 
+    /**
+     * Endpoints that share a rate limit bucket. Infisical's quotas for logins are much lower than for reads.
+     */
+    enum class EndpointClass
+    {
+      AUTH,
+      SECRETS,
+      OTHER
+    };
+
+    struct RateLimit
+    {
+      EndpointClass endpointClass;
+      double requestsPerSecond;
+      size_t burst;
+    };
+
+    /**
+     * Client-side token buckets, one per endpoint class, that keep a burst of calls under the server's quotas instead of running into 429s.
+     * Calls that find their bucket empty wait in line and get tokens in arrival order.
+     */
+    class RateLimiter
+    {
+    public:
+      /**
+       * Allow `requestsPerSecond` on average, in bursts of up to `burst` requests. A rate of 0 removes the limit.
+       */
+      void setLimit(EndpointClass endpointClass, double requestsPerSecond, size_t burst);
+
+      /**
+       * Take a token, waiting in line for one if the bucket is empty. Returns false once it's clear the token can't be had before `deadline`,
+       * which for a call with many others queued ahead of it is right away.
+       */
+      bool acquire(EndpointClass endpointClass, std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt);
+
+      static EndpointClass classify(std::string_view endpoint);
+
+      void prepareFork();
+      void afterForkInParent();
+
+      /**
+       * Drops the queue, its waiters were threads of the parent.
+       */
+      void afterForkInChild();
+
+    private:
+      struct Bucket
+      {
+        double rate = 0;
+        double capacity = 0;
+        double tokens = 0;
+        std::chrono::steady_clock::time_point refilled;
+        // each waiter sleeps on its own condition variable, so handing over the front only wakes the next in line
+        std::list<std::condition_variable *> waiters;
+      };
+
+      std::mutex m_mutex;
+      Bucket m_buckets[3];
+
+      static void refill(Bucket &bucket, std::chrono::steady_clock::time_point now);
+      static std::chrono::steady_clock::duration timeUntil(const Bucket &bucket, size_t tokens);
+    };
+
+    struct CurlSlistDeleter
+    {
+      void operator()(curl_slist *list) const { curl_slist_free_all(list); }
+    };
+
+    /**
+     * libcurl share handle that lets the short-lived per-request sessions of an HttpClient reuse each other's connections, DNS lookups and TLS sessions, so concurrent and back-to-back requests don't each pay a new TCP connect and full TLS handshake.
+     */
+    class ConnectionShare
+    {
+    public:
+      ConnectionShare();
+      ~ConnectionShare();
+      ConnectionShare(const ConnectionShare &) = delete;
+      ConnectionShare &operator=(const ConnectionShare &) = delete;
+
+      void attach(cpr::Session &session) const;
+
+      void prepareFork();
+      void afterForkInParent();
+
+      /**
+       * Switch to a fresh share handle. The inherited one is left alone, cleaning it up would shut down the parent's TLS connections.
+       */
+      void afterForkInChild();
+
+    private:
+      CURLSH *createHandle();
+
+      static void lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+      static void unlock(CURL *handle, curl_lock_data data, void *userptr);
+
+      CURLSH *m_handle;
+      std::mutex m_locks[CURL_LOCK_DATA_LAST];
+    };
+
     class HttpClient
     {
     public:
       HttpClient();
       explicit HttpClient(const std::string &baseUrl);
 
+      /**
+       * Client that reuses the connections of every other client created with the same `share`.
+       */
+      HttpClient(const std::string &baseUrl, std::shared_ptr<ConnectionShare> share);
+
       void setBaseUrl(const std::string &baseUrl);
       void setDefaultHeader(const std::string &name, const std::string &value);
+
+      /**
+       * Set the Bearer token sent with every request. Kept apart from the default headers so it can live in secure memory.
+       * cpr copies the header into each request's session and libcurl's header list, those copies aren't wiped.
+       */
+      void setAccessToken(std::string_view accessToken);
+
+      ConnectionShare &connectionShare() { return *m_share; }
+
+      /**
+       * How long resolved host names stay in the DNS cache all requests share. Defaults to libcurl's 60 seconds. A negative value keeps them forever.
+       */
+      void setDnsCacheTimeout(std::chrono::seconds timeout);
+
+      /**
+       * Resolve a host to a fixed address instead of asking DNS, in libcurl's `CURLOPT_RESOLVE` format: "host:port:address[,address]...".
+       */
+      void addResolveOverride(const std::string &entry);
+
+      /**
+       * Verify the server against the CA certificates in this PEM file instead of the system store, e.g. for a self-hosted instance behind a private CA.
+       */
+      void setCaBundle(const std::string &path);
+
+      /**
+       * Throttle requests through `limiter`, which can be shared with other clients. Pass nullptr to stop limiting.
+       */
+      void setRateLimiter(std::shared_ptr<RateLimiter> limiter);
+
+      RateLimiter *rateLimiter() { return m_rateLimiter.get(); }
+
       cpr::Response request(
           Method method,
           const std::string &endpoint,
@@ -724,6 +2362,82 @@ namespace Infisical
           const std::map<std::string, std::string> &params = {},
           const std::string &body = "");
 
+      /**
+       * Like `request()`, but the response body is passed to `onBody` chunk by chunk as it arrives instead of being collected into `cpr::Response::text`.
+       * Returning false from `onBody` aborts the transfer. Error responses are not passed to `onBody`; they raise an `InfisicalError` as usual. Returns the status code.
+       * Requests are built in per-thread scratch space, so `onBody` must not start another request on the same thread.
+       */
+      long requestStreaming(
+          Method method,
+          const std::string &endpoint,
+          const std::function<bool(std::string_view)> &onBody,
+          const std::map<std::string, std::string> &headers = {},
+          const std::map<std::string, std::string> &params = {},
+          const std::string &body = "");
+
+      /**
+       * Like `request()`, but the response body is written straight into `buffer`, which is cleared first. The buffer keeps its capacity, so reusing it across requests avoids reallocating for every response.
+       */
+      template <typename Buffer>
+      long requestInto(
+          Method method,
+          const std::string &endpoint,
+          Buffer &buffer,
+          const std::map<std::string, std::string> &headers = {},
+          const std::map<std::string, std::string> &params = {},
+          const std::string &body = "")
+      {
+        buffer.clear();
+        return requestStreaming(
+            method, endpoint, [&buffer](std::string_view data)
+            {
+              buffer.append(data.data(), data.size());
+              return true; },
+            headers, params, body);
+      }
+
+      /**
+       * Like `request()`, but an error response or a network error is returned instead of thrown.
+       */
+      Result<cpr::Response> tryRequest(
+          Method method,
+          const std::string &endpoint,
+          const std::map<std::string, std::string> &headers = {},
+          const std::map<std::string, std::string> &params = {},
+          const std::string &body = "");
+
+      /**
+       * Like `requestStreaming()`, but an error response or a network error is returned instead of thrown.
+       */
+      Result<long> tryRequestStreaming(
+          Method method,
+          const std::string &endpoint,
+          const std::function<bool(std::string_view)> &onBody,
+          const std::map<std::string, std::string> &headers = {},
+          const std::map<std::string, std::string> &params = {},
+          const std::string &body = "");
+
+      /**
+       * Like `requestInto()`, but an error response or a network error is returned instead of thrown.
+       */
+      template <typename Buffer>
+      Result<long> tryRequestInto(
+          Method method,
+          const std::string &endpoint,
+          Buffer &buffer,
+          const std::map<std::string, std::string> &headers = {},
+          const std::map<std::string, std::string> &params = {},
+          const std::string &body = "")
+      {
+        buffer.clear();
+        return tryRequestStreaming(
+            method, endpoint, [&buffer](std::string_view data)
+            {
+              buffer.append(data.data(), data.size());
+              return true; },
+            headers, params, body);
+      }
+
       cpr::Response get(
           const std::string &endpoint,
           const std::map<std::string, std::string> &headers = {},
@@ -746,11 +2460,29 @@ namespace Infisical
 
     private:
       std::string m_baseUrl;
-      std::map<std::string, std::string> m_defaultHeaders;
+      cpr::Header m_defaultHeaders;
+      SecretString m_authorizationHeader;
+      // the token can be renewed while other threads are sending requests with it
+      std::mutex m_authorizationMutex;
       long m_timeout;
+      long m_dnsCacheTimeout = 60;
+      std::unique_ptr<curl_slist, CurlSlistDeleter> m_resolveOverrides;
+      std::string m_caBundle;
+      std::shared_ptr<ConnectionShare> m_share;
+      std::shared_ptr<RateLimiter> m_rateLimiter;
 
-      cpr::Header mergeHeaders(const std::map<std::string, std::string> &headers);
+      void mergeHeaders(const std::map<std::string, std::string> &headers, cpr::Header &merged);
       cpr::Parameters convertParams(const std::map<std::string, std::string> &params);
+
+      cpr::Response perform(
+          Method method,
+          const std::string &url,
+          const std::map<std::string, std::string> &headers,
+          const std::map<std::string, std::string> &params,
+          const std::string &body,
+          const std::function<bool(std::string_view)> *onBody);
+      std::optional<InfisicalError> checkResponse(Method method, const std::string &url, const std::string &endpoint, cpr::Response &response);
+      std::optional<InfisicalError> admit(const std::string &endpoint);
     };
   }
 
@@ -764,25 +2496,61 @@ namespace Infisical
     class MachineIdentityLoginResponse
     {
     public:
-      std::string accessToken;
+      SecretString accessToken;
       int expiresIn;
       int accessTokenMaxTTL;
       std::string tokenType;
 
       MachineIdentityLoginResponse() = default;
       MachineIdentityLoginResponse(
-          const std::string &accessToken,
+          const SecretString &accessToken,
           int expiresIn,
           int accessTokenMaxTTL,
           const std::string &tokenType) : accessToken(accessToken),
                                           expiresIn(expiresIn),
                                           accessTokenMaxTTL(accessTokenMaxTTL),
                                           tokenType(tokenType) {}
+      MachineIdentityLoginResponse(const MachineIdentityLoginResponse &) = default;
+      MachineIdentityLoginResponse(MachineIdentityLoginResponse &&) = default;
+      MachineIdentityLoginResponse &operator=(const MachineIdentityLoginResponse &other) { return *this = MachineIdentityLoginResponse(other); }
+
+      // wipes the replaced token first, a short one lives inside the string object
+      MachineIdentityLoginResponse &operator=(MachineIdentityLoginResponse &&other) noexcept
+      {
+        if (this != &other)
+        {
+          secure::wipe(accessToken);
+          accessToken = std::move(other.accessToken);
+          expiresIn = other.expiresIn;
+          accessTokenMaxTTL = other.accessTokenMaxTTL;
+          tokenType = std::move(other.tokenType);
+          secure::wipe(other.accessToken);
+        }
+        return *this;
+      }
 
-      // macro to generate from_json and to_json functions
-      NLOHMANN_DEFINE_TYPE_INTRUSIVE(MachineIdentityLoginResponse,
-                                     accessToken, expiresIn,
-                                     accessTokenMaxTTL, tokenType)
+      // every copy of the response holds the token, don't leave it behind in freed memory
+      ~MachineIdentityLoginResponse() { secure::wipe(accessToken); }
+
+      // the token goes through a plain std::string inside the json, callers wipe that one
+      friend void from_json(const nlohmann::json &j, MachineIdentityLoginResponse &response)
+      {
+        const auto &accessToken = j.at("accessToken").get_ref<const std::string &>();
+        secure::wipe(response.accessToken);
+        response.accessToken.assign(accessToken.data(), accessToken.size());
+        j.at("expiresIn").get_to(response.expiresIn);
+        j.at("accessTokenMaxTTL").get_to(response.accessTokenMaxTTL);
+        j.at("tokenType").get_to(response.tokenType);
+      }
+
+      friend void to_json(nlohmann::json &j, const MachineIdentityLoginResponse &response)
+      {
+        j = nlohmann::json{
+            {"accessToken", std::string(response.accessToken.data(), response.accessToken.size())},
+            {"expiresIn", response.expiresIn},
+            {"accessTokenMaxTTL", response.accessTokenMaxTTL},
+            {"tokenType", response.tokenType}};
+      }
     };
 
     class AuthClient
@@ -791,11 +2559,92 @@ namespace Infisical
       Infisical::Config &config;
       Infisical::http::HttpClient *httpClient;
 
+      std::function<void(const MachineIdentityLoginResponse &)> _onLogin;
+      std::mutex _loginMutex;
+      std::atomic<bool> _loginPending{false};
+      std::shared_future<void> _login;
+      uint64_t _loginAttempt = 0;
+
+      MachineIdentityLoginResponse login(bool reuseCachedToken);
+      void startLoginLocked();
+
     public:
       explicit AuthClient(Infisical::Config &config, http::HttpClient *httpClient);
 
-      MachineIdentityLoginResponse universalAuthLogin(const std::string &clientId, const std::string &clientSecret);
+      /**
+       * Waits for a login still running in the background, which may call the login observer.
+       */
+      ~AuthClient();
+      AuthClient(const AuthClient &) = delete;
+      AuthClient &operator=(const AuthClient &) = delete;
+
+      MachineIdentityLoginResponse universalAuthLogin(const std::string &clientId, const SecretString &clientSecret);
       MachineIdentityLoginResponse universalAuthLogin();
+
+      /**
+       * Log in with the configured authentication, going through the token cache when one is configured.
+       */
+      MachineIdentityLoginResponse login();
+
+      /**
+       * Log in even if the token cache still holds a valid token, and store the new token in it.
+       */
+      MachineIdentityLoginResponse renewLogin();
+
+      /**
+       * Called after every successful `login()`, on the thread that logged in. Set it before the first login.
+       */
+      void setLoginObserver(std::function<void(const MachineIdentityLoginResponse &)> observer);
+
+      /**
+       * Start `login()` in the background. Requests must call `awaitLogin()` first.
+       */
+      void startLogin();
+
+      /**
+       * Require a login without starting one. The first `awaitLogin()` performs it.
+       */
+      void deferLogin();
+
+      /**
+       * Waits for a login running in the background, then holds the login lock until one of the after-fork hooks.
+       */
+      void prepareFork();
+      void afterForkInParent();
+      void afterForkInChild();
+
+      /**
+       * Wait for a login started by `startLogin()`. Returns right away once a login succeeded. If the login failed its error is thrown, and the next call starts a new login attempt.
+       */
+      void awaitLogin();
+    };
+
+    /**
+     * Login responses shared between processes through a file only the current user can read.
+     * Entries are tied to an identity (host URL, client ID and client secret) and are only reused while the token has at least a minute left.
+     * While one process logs in, others using the same file wait for it and pick up its token instead of logging in themselves.
+     */
+    class TokenCache
+    {
+    public:
+      TokenCache(std::string path, const std::string &hostUrl, const std::string &clientId, const SecretString &clientSecret);
+
+      std::optional<MachineIdentityLoginResponse> load() const;
+      void store(const MachineIdentityLoginResponse &response) const;
+
+      /**
+       * Return a cached token, or call `login` and cache its result. Problems with the cache file never fail the login, the cache is skipped instead.
+       */
+      MachineIdentityLoginResponse getOrLogin(const std::function<MachineIdentityLoginResponse()> &login) const;
+
+      /**
+       * Call `login` without looking at the cache and cache its result, holding the same lock as `getOrLogin()`.
+       */
+      MachineIdentityLoginResponse renew(const std::function<MachineIdentityLoginResponse()> &login) const;
+
+    private:
+      std::string _path;
+      std::string _identity;
     };
   }
 
@@ -805,9 +2654,29 @@ namespace Infisical
     friend class AuthenticationBuilder;
     friend class InfisicalClient;
 
+    Authentication() = default;
+    Authentication(const Authentication &) = default;
+    Authentication(Authentication &&) = default;
+    Authentication &operator=(const Authentication &other) { return *this = Authentication(other); }
+
+    // wipes the replaced secret first, a short one lives inside the string object
+    Authentication &operator=(Authentication &&other) noexcept
+    {
+      if (this != &other)
+      {
+        secure::wipe(_clientSecret);
+        _authStrategy = other._authStrategy;
+        _clientId = std::move(other._clientId);
+        _clientSecret = std::move(other._clientSecret);
+        secure::wipe(other._clientSecret);
+      }
+      return *this;
+    }
+    ~Authentication() { secure::wipe(_clientSecret); }
+
     AuthStrategy _authStrategy;
     std::string _clientId;
-    std::string _clientSecret;
+    SecretString _clientSecret;
   };
 
   class AuthenticationBuilder
@@ -836,12 +2705,42 @@ namespace Infisical
 
     Authentication getAuthentication() const { return this->authentication_; }
 
+    const std::string &getTokenCachePath() const { return tokenCachePath_; }
+
+    bool getDeferredLogin() const { return deferredLogin_; }
+
+    const std::string &getAgentSocketPath() const { return agentSocketPath_; }
+
+    std::chrono::milliseconds getMissingSecretCacheTtl() const { return missingSecretCacheTtl_; }
+
+    std::chrono::seconds getDnsCacheTtl() const { return dnsCacheTtl_; }
+
+    const std::vector<std::string> &getResolveOverrides() const { return resolveOverrides_; }
+
+    const std::string &getCaBundle() const { return caBundle_; }
+
+    const std::vector<http::RateLimit> &getRateLimits() const { return rateLimits_; }
+
+    bool getTokenRenewal() const { return tokenRenewal_; }
+
+    double getRefreshJitter() const { return refreshJitter_; }
+
   private:
     Config()
         : url_("") {}
 
     std::string url_;
     Authentication authentication_;
+    std::string tokenCachePath_;
+    bool deferredLogin_ = false;
+    std::string agentSocketPath_;
+    std::chrono::milliseconds missingSecretCacheTtl_{0};
+    std::chrono::seconds dnsCacheTtl_{60};
+    std::vector<std::string> resolveOverrides_;
+    std::string caBundle_;
+    std::vector<http::RateLimit> rateLimits_;
+    bool tokenRenewal_ = false;
+    double refreshJitter_ = 0.1;
   };
 
   // Now define ConfigBuilder after Config is fully defined
@@ -852,22 +2751,403 @@ namespace Infisical
 
     ConfigBuilder &withAuthentication(Authentication &&auth);
     ConfigBuilder &withHostUrl(std::string url);
+    ConfigBuilder &withTokenCacheFile(std::string path);
+    ConfigBuilder &withDeferredLogin(bool deferredLogin);
+    ConfigBuilder &withAgentSocket(std::string socketPath);
+    ConfigBuilder &withMissingSecretCacheTtl(std::chrono::milliseconds ttl);
+    ConfigBuilder &withDnsCacheTtl(std::chrono::seconds ttl);
+    ConfigBuilder &withResolveOverride(std::string entry);
+    ConfigBuilder &withCaBundle(std::string path);
+    ConfigBuilder &withRateLimit(http::EndpointClass endpointClass, double requestsPerSecond, size_t burst);
+    ConfigBuilder &withTokenRenewal(bool tokenRenewal);
+    ConfigBuilder &withRefreshJitter(double jitter);
     Config &build();
 
   private:
     Config config_;
   };
 
-  class InfisicalClient
+  // -------------------------------------------- AGENT
+  namespace agent
+  {
+
+    /**
+     * Wire protocol between the SDK and `infisical_agent`, spoken over a Unix domain socket. All integers are in host byte order, the socket never leaves the host.
+     *
+     * Request:  u32 length | u8 operation | u8 flags | str projectId | str environment | str secretPath | str secretKey
+     * Response: u32 length | u8 status | payload
+     *
+     * `str` is a u32 length followed by the bytes, `length` counts the bytes after itself. On `OK` the payload is a serialized `SecretSnapshot`, on `ERROR` an error message.
+     */
+    enum class AgentOperation : uint8_t
+    {
+      LIST_SECRETS = 1,
+      GET_SECRET = 2,
+    };
+
+    enum class AgentStatus : uint8_t
+    {
+      OK = 0,
+      NOT_FOUND = 1,
+      UNKNOWN_SCOPE = 2,
+      ERROR = 3,
+    };
+
+    constexpr uint8_t AGENT_FLAG_RECURSIVE = 1u << 0;
+    constexpr uint8_t AGENT_FLAG_EXPAND_SECRET_REFERENCES = 1u << 1;
+
+    /**
+     * SDK side of the agent protocol. Keeps one connection open and reconnects when the agent restarts.
+     * Every read returns `std::nullopt` when the agent can't answer it (not running, scope not served, key not found), so callers fall back to the API.
+     */
+    class AgentClient
+    {
+    public:
+      explicit AgentClient(std::string socketPath);
+      ~AgentClient();
+      AgentClient(const AgentClient &) = delete;
+      AgentClient &operator=(const AgentClient &) = delete;
+
+      std::optional<Secrets::SecretSnapshot> listSecrets(const Input::ListSecretsOptions &options);
+      std::optional<Secrets::SecretSnapshot> getSecret(const Input::GetSecretOptions &options);
+
+      void prepareFork();
+      void afterForkInParent();
+
+      /**
+       * Drop the connection inherited from the parent, the child connects on its next read.
+       */
+      void afterForkInChild();
+
+    private:
+      std::optional<Secrets::SecretSnapshot> query(AgentOperation operation, uint8_t flags, const std::string &projectId, const std::string &environment, const std::string &secretPath, const std::string &secretKey);
+      bool connect();
+      void disconnect();
+
+      std::string _socketPath;
+      int _fd = -1;
+      std::chrono::steady_clock::time_point _retryAfter;
+      std::mutex _mutex;
+    };
+
+    /**
+     * Agent side of the protocol: keeps the configured scopes in memory, refreshes them periodically and answers reads from local processes.
+     * Only processes running as the same user as the agent are served.
+     */
+    class AgentServer
+    {
+    public:
+      AgentServer(InfisicalClient &client, std::string socketPath, std::vector<Input::ListSecretsOptions> scopes, std::chrono::seconds refreshInterval);
+      ~AgentServer();
+      AgentServer(const AgentServer &) = delete;
+      AgentServer &operator=(const AgentServer &) = delete;
+
+      /**
+       * Fetch every scope now. A scope that fails to refresh keeps serving its previous contents. Returns false if any scope failed.
+       */
+      bool refresh();
+
+      /**
+       * Listen on the socket and serve requests until `stop()` is called, refreshing the scopes in between.
+       */
+      void serve();
+
+      /**
+       * Make `serve()` return. Async-signal-safe, so it can be called from a SIGTERM handler.
+       */
+      void stop();
+
+      /**
+       * Called with a description of every failed scope refresh. Without a handler, failures are silent and the previous contents keep being served.
+       */
+      void setErrorHandler(std::function<void(const std::string &)> handler);
+
+      /**
+       * Fraction of the refresh interval by which each scope's refreshes are moved at random, so agents started together don't all refresh at once. Defaults to 0.1.
+       */
+      void setRefreshJitter(double jitter);
+
+    private:
+      struct Scope;
+      struct Connection;
+
+      bool refreshScope(const Input::ListSecretsOptions &options);
+      void handle(Connection &connection, std::string_view request);
+
+      /**
+       * Read and write whatever the socket allows without blocking. Returns false once the connection should be closed.
+       */
+      bool service(Connection &connection, short events);
+      std::shared_ptr<const Scope> findScope(const std::string &scopeKey);
+
+      InfisicalClient &_client;
+      std::string _socketPath;
+      std::vector<Input::ListSecretsOptions> _scopeOptions;
+      std::chrono::seconds _refreshInterval;
+      double _refreshJitter = 0.1;
+      std::function<void(const std::string &)> _errorHandler;
+
+      // swapped whole on refresh, requests keep using the scope they looked up until they're done with it
+      std::mutex _scopesMutex;
+      std::unordered_map<std::string, std::shared_ptr<const Scope>> _scopes;
+
+      std::atomic<bool> _stopping{false};
+      int _wakeFds[2] = {-1, -1};
+    };
+  }
+
+  class InfisicalClient : public ForkAware
   {
     Infisical::Config _config;
     Infisical::http::HttpClient _httpClient;
+    // outlives _authClient, whose background login may still schedule a renewal while it is destroyed
+    std::unique_ptr<RefreshScheduler> _scheduler;
     Infisical::auth::AuthClient _authClient;
+    std::unique_ptr<Infisical::agent::AgentClient> _agentClient;
     Infisical::Secrets::SecretsClient _secretsClient;
 
   public:
     explicit InfisicalClient(Config &config);
     ~InfisicalClient();
     Secrets::SecretsClient &secrets() { return _secretsClient; }
+
+    void prepareFork() override;
+    void afterForkInParent() override;
+    void afterForkInChild() override;
+
+  private:
+    void scheduleTokenRenewal(std::chrono::milliseconds delay);
+  };
+
+  /**
+   * Fixed set of threads running submitted tasks in FIFO order.
+   */
+  class WorkerPool
+  {
+  public:
+    explicit WorkerPool(size_t threads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<decltype(fn())>
+    {
+      auto task = std::make_shared<std::packaged_task<decltype(fn())()>>(std::move(fn));
+      auto result = task->get_future();
+      enqueue([task]()
+              { (*task)(); });
+      return result;
+    }
+
+    /**
+     * Let running tasks finish, hold back queued ones and keep the queue locked until one of the after-fork hooks.
+     */
+    void prepareFork();
+    void afterForkInParent();
+
+    /**
+     * Start new threads, the parent's don't exist in the child. Tasks queued at fork time are dropped, their futures report `std::future_errc::broken_promise`.
+     */
+    void afterForkInChild();
+
+  private:
+    void enqueue(std::function<void()> task);
+    void run();
+    void startThreads(size_t count);
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _idle;
+    std::deque<std::function<void()>> _tasks;
+    bool _stopping = false;
+    bool _paused = false;
+    size_t _running = 0;
+    std::vector<std::thread> _threads;
+  };
+
+  /**
+   * Runs periodic refreshes, such as cache reloads and token renewals, on one background thread.
+   * Due times are kept in a timer wheel, a ring of `slots` buckets that each cover one `tick`. The thread wakes once per tick while anything
+   * is scheduled, however many tasks there are, and not at all while nothing is.
+   * Every due time is moved at random by up to `jitter` (a fraction of the task's interval), so processes started together drift apart instead of
+   * refreshing in lockstep.
+   */
+  class RefreshScheduler
+  {
+  public:
+    using TaskId = uint64_t;
+
+    explicit RefreshScheduler(double jitter = 0.1, std::chrono::milliseconds tick = std::chrono::seconds(1), size_t slots = 512);
+    ~RefreshScheduler();
+    RefreshScheduler(const RefreshScheduler &) = delete;
+    RefreshScheduler &operator=(const RefreshScheduler &) = delete;
+
+    /**
+     * Run `task` every `interval`, counted from the end of its previous run. The first run comes after a random part of one interval.
+     * Tasks run one at a time on the scheduler's thread; exceptions they throw are dropped.
+     */
+    TaskId scheduleEvery(std::chrono::milliseconds interval, std::function<void()> task);
+
+    /**
+     * Run `task` once after `delay`. Jitter only ever makes it earlier, so a refresh due before an expiry still happens before it.
+     */
+    TaskId scheduleOnce(std::chrono::milliseconds delay, std::function<void()> task);
+
+    /**
+     * Remove a task. If it's running on another thread, waits for that run to finish.
+     */
+    void cancel(TaskId id);
+
+    /**
+     * Drop every task and stop the thread, after waiting for a running task. Tasks scheduled afterwards are ignored.
+     */
+    void stop();
+
+    /**
+     * Wait for a running task and keep the wheel locked until one of the after-fork hooks.
+     */
+    void prepareFork();
+    void afterForkInParent();
+
+    /**
+     * Start a new thread and reseed the jitter, so forked workers don't all pick the same due times. Scheduled tasks are kept.
+     */
+    void afterForkInChild();
+
+  private:
+    struct Task
+    {
+      std::chrono::milliseconds interval;
+      bool repeating;
+      uint64_t dueTick;
+      std::shared_ptr<std::function<void()>> run;
+    };
+
+    struct SlotEntry
+    {
+      TaskId id;
+      uint64_t dueTick;
+    };
+
+    TaskId add(std::chrono::milliseconds interval, bool repeating, std::chrono::milliseconds delay, std::function<void()> task);
+    void placeLocked(TaskId id, Task &task, std::chrono::milliseconds delay);
+    double randomFraction();
+    void run();
+
+    double _jitter;
+    std::chrono::milliseconds _tick;
+    std::chrono::steady_clock::time_point _start;
+    std::vector<std::vector<SlotEntry>> _wheel;
+    // the last tick whose slot was processed
+    uint64_t _currentTick = 0;
+    std::unordered_map<TaskId, Task> _tasks;
+    TaskId _nextId = 1;
+    TaskId _running = 0;
+    std::mt19937_64 _random;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _idle;
+    bool _stopping = false;
+    bool _paused = false;
+    std::thread _thread;
+  };
+
+  /**
+   * Serves many machine identities ("tenants") from one process. Every tenant keeps its own login and access token,
+   * but all of them send their requests over one pool of connections and run background work on one `WorkerPool`.
+   *
+   * Listings made through the manager are cached per tenant. When the cached listings of all tenants together
+   * grow past the memory limit, the listings of the tenants that were used least recently are dropped first.
+   */
+  class ClientManager : public ForkAware
+  {
+  public:
+    /**
+     * @param hostUrl Infisical instance every tenant talks to
+     * @param cacheTtl How long a cached listing is served before it's fetched again
+     * @param cacheMemoryLimit Approximate upper bound, in bytes, for the cached listings of all tenants together
+     * @param workerThreads Threads of the shared worker pool
+     */
+    explicit ClientManager(std::string hostUrl,
+                           std::chrono::milliseconds cacheTtl = std::chrono::seconds(60),
+                           size_t cacheMemoryLimit = 64 * 1024 * 1024,
+                           size_t workerThreads = 4);
+
+    /**
+     * Manager whose tenants use the host URL, DNS cache TTL, resolve overrides, CA bundle and missing-secret cache TTL of `settings`.
+     * Its rate limits apply to all tenants together. Authentication, token cache file, agent socket, deferred login and token renewal are ignored.
+     */
+    explicit ClientManager(Config settings,
+                           std::chrono::milliseconds cacheTtl = std::chrono::seconds(60),
+                           size_t cacheMemoryLimit = 64 * 1024 * 1024,
+                           size_t workerThreads = 4);
+    ~ClientManager();
+    ClientManager(const ClientManager &) = delete;
+    ClientManager &operator=(const ClientManager &) = delete;
+
+    /**
+     * Register a tenant, or replace the identity of an existing one (which drops its token and cache). The tenant logs in on its first request.
+     */
+    void addTenant(const std::string &tenantId, Authentication authentication);
+    void removeTenant(const std::string &tenantId);
+    bool hasTenant(const std::string &tenantId) const;
+
+    /**
+     * Secrets client of a tenant, for calls the manager doesn't cache. Stays usable after the tenant is removed or replaced.
+     * Throws `std::invalid_argument` for unknown tenants.
+     */
+    std::shared_ptr<Secrets::SecretsClient> secrets(const std::string &tenantId);
+
+    /**
+     * List secrets as `tenantId`, from the tenant's cache while the listing is younger than the cache TTL.
+     * Throws `std::invalid_argument` for options that add the secrets to environment variables.
+     */
+    std::shared_ptr<const std::vector<Secrets::TSecret>> listSecrets(const std::string &tenantId, const Input::ListSecretsOptions &options);
+
+    /**
+     * `listSecrets()` on the shared worker pool.
+     */
+    std::future<std::shared_ptr<const std::vector<Secrets::TSecret>>> listSecretsAsync(const std::string &tenantId, Input::ListSecretsOptions options);
+
+    /**
+     * Drop the cached listings of one tenant.
+     */
+    void invalidate(const std::string &tenantId);
+
+    /**
+     * Approximate bytes held by the cached listings of all tenants.
+     */
+    size_t cacheMemoryUsage() const;
+
+    void prepareFork() override;
+    void afterForkInParent() override;
+    void afterForkInChild() override;
+
+  private:
+    struct Tenant;
+
+    std::shared_ptr<Tenant> findTenant(const std::string &tenantId) const;
+    void dropListingsLocked(Tenant &tenant);
+    void evictLocked(const Tenant *keep);
+
+    Config _settings;
+    std::chrono::milliseconds _cacheTtl;
+    size_t _cacheMemoryLimit;
+    std::shared_ptr<http::ConnectionShare> _share;
+    std::shared_ptr<http::RateLimiter> _rateLimiter;
+
+    mutable std::mutex _tenantsMutex;
+    std::unordered_map<std::string, std::shared_ptr<Tenant>> _tenants;
+
+    // guards the cached listings of every tenant and the accounting below
+    mutable std::mutex _cacheMutex;
+    size_t _cacheMemoryUsage = 0;
+    // tenants holding cached listings, most recently used first
+    std::list<Tenant *> _recentlyUsed;
+
+    // last member, so its threads are joined before anything they use is destroyed
+    WorkerPool _workers;
   };
 } // namespace Infisical
\ No newline at end of file
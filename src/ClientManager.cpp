@@ -0,0 +1,350 @@
+#include <libinfisical/InfisicalClient.h>
+
+namespace
+{
+  std::string listingKeyOf(const Infisical::Input::ListSecretsOptions &options)
+  {
+    // \x1f (unit separator) can't appear in IDs, slugs or paths
+    std::string key;
+    key.append(options.getProjectId())
+        .append(1, '\x1f')
+        .append(options.getEnvironment())
+        .append(1, '\x1f')
+        .append(options.getSecretPath())
+        .append(1, '\x1f')
+        .append(options.getRecursive() ? "r" : "-")
+        .append(options.getExpandSecretReferences() ? "e" : "-");
+    for (const auto &tag : options.getTagSlugs())
+    {
+      key.append(1, '\x1f').append(tag);
+    }
+    return key;
+  }
+
+  Infisical::Config settingsFor(std::string hostUrl)
+  {
+    if (hostUrl.empty())
+    {
+      throw std::invalid_argument("ClientManager host URL cannot be empty");
+    }
+    return Infisical::ConfigBuilder().withHostUrl(std::move(hostUrl)).build();
+  }
+
+  // the manager's connection settings with the tenant's identity
+  Infisical::Config tenantConfigOf(const Infisical::Config &settings, Infisical::Authentication authentication)
+  {
+    Infisical::ConfigBuilder builder;
+    builder.withHostUrl(settings.getUrl())
+        .withAuthentication(std::move(authentication))
+        .withMissingSecretCacheTtl(settings.getMissingSecretCacheTtl())
+        .withDnsCacheTtl(settings.getDnsCacheTtl())
+        .withCaBundle(settings.getCaBundle());
+    for (const auto &entry : settings.getResolveOverrides())
+    {
+      builder.withResolveOverride(entry);
+    }
+    return builder.build();
+  }
+
+  size_t approximateSize(const std::vector<Infisical::Secrets::TSecret> &secrets)
+  {
+    size_t size = sizeof(secrets) + secrets.capacity() * sizeof(Infisical::Secrets::TSecret);
+    for (const auto &secret : secrets)
+    {
+      size += secret.getId().capacity() + secret.getWorkspace().capacity() + secret.getEnvironment().capacity() +
+              secret.getType().capacity() + secret.getSecretKey().capacity() + secret.getSecretValue().capacity() +
+              secret.getSecretPath().capacity() + secret.getRotationId().size();
+      for (const auto &metadata : secret.getSecretMetadata())
+      {
+        size += sizeof(metadata) + metadata.getKey().capacity() + metadata.getValue().capacity();
+      }
+    }
+    return size;
+  }
+}
+
+namespace Infisical
+{
+
+  struct ClientManager::Tenant
+  {
+    struct Listing
+    {
+      std::shared_ptr<const std::vector<Secrets::TSecret>> secrets;
+      std::chrono::steady_clock::time_point fetchedAt;
+      size_t size;
+    };
+
+    Tenant(const Config &settings, Authentication authentication, std::shared_ptr<http::ConnectionShare> share, std::shared_ptr<http::RateLimiter> rateLimiter)
+        : config(tenantConfigOf(settings, std::move(authentication))),
+          httpClient(config.getUrl(), std::move(share)),
+          authClient(config, &httpClient),
+          secretsClient(&httpClient, &authClient)
+    {
+      secretsClient.setMissingSecretCacheTtl(config.getMissingSecretCacheTtl());
+      httpClient.setDnsCacheTimeout(config.getDnsCacheTtl());
+      for (const auto &entry : config.getResolveOverrides())
+      {
+        httpClient.addResolveOverride(entry);
+      }
+      if (!config.getCaBundle().empty())
+      {
+        httpClient.setCaBundle(config.getCaBundle());
+      }
+      httpClient.setRateLimiter(std::move(rateLimiter));
+      authClient.deferLogin();
+    }
+
+    Config config;
+    http::HttpClient httpClient;
+    auth::AuthClient authClient;
+    Secrets::SecretsClient secretsClient;
+
+    // guarded by ClientManager::_cacheMutex
+    std::unordered_map<std::string, Listing> listings;
+    size_t cacheSize = 0;
+    bool removed = false;
+    bool recentlyUsed = false;
+    std::list<Tenant *>::iterator recentlyUsedPosition;
+  };
+
+  ClientManager::ClientManager(std::string hostUrl, std::chrono::milliseconds cacheTtl, size_t cacheMemoryLimit, size_t workerThreads)
+      : ClientManager(settingsFor(std::move(hostUrl)), cacheTtl, cacheMemoryLimit, workerThreads)
+  {
+  }
+
+  ClientManager::ClientManager(Config settings, std::chrono::milliseconds cacheTtl, size_t cacheMemoryLimit, size_t workerThreads)
+      : _settings(std::move(settings)),
+        _cacheTtl(cacheTtl),
+        _cacheMemoryLimit(cacheMemoryLimit),
+        _share(std::make_shared<http::ConnectionShare>()),
+        _workers(workerThreads)
+  {
+    // one limiter for every tenant, like the connections they share
+    if (!_settings.getRateLimits().empty())
+    {
+      _rateLimiter = std::make_shared<http::RateLimiter>();
+      for (const auto &limit : _settings.getRateLimits())
+      {
+        _rateLimiter->setLimit(limit.endpointClass, limit.requestsPerSecond, limit.burst);
+      }
+    }
+
+    registerForFork();
+  }
+
+  ClientManager::~ClientManager()
+  {
+    unregisterForFork();
+  }
+
+  void ClientManager::addTenant(const std::string &tenantId, Authentication authentication)
+  {
+    if (authentication._authStrategy != AuthStrategy::UNIVERSAL_AUTH)
+    {
+      throw std::invalid_argument("Unsupported authentication strategy");
+    }
+
+    auto tenant = std::make_shared<Tenant>(_settings, std::move(authentication), _share, _rateLimiter);
+
+    std::shared_ptr<Tenant> replaced;
+    {
+      std::lock_guard<std::mutex> lock(_tenantsMutex);
+      auto &slot = _tenants[tenantId];
+      replaced = std::move(slot);
+      slot = std::move(tenant);
+    }
+
+    if (replaced)
+    {
+      std::lock_guard<std::mutex> lock(_cacheMutex);
+      replaced->removed = true;
+      dropListingsLocked(*replaced);
+    }
+  }
+
+  void ClientManager::removeTenant(const std::string &tenantId)
+  {
+    std::shared_ptr<Tenant> removed;
+    {
+      std::lock_guard<std::mutex> lock(_tenantsMutex);
+      auto it = _tenants.find(tenantId);
+      if (it == _tenants.end())
+      {
+        return;
+      }
+      removed = std::move(it->second);
+      _tenants.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    removed->removed = true;
+    dropListingsLocked(*removed);
+  }
+
+  bool ClientManager::hasTenant(const std::string &tenantId) const
+  {
+    std::lock_guard<std::mutex> lock(_tenantsMutex);
+    return _tenants.find(tenantId) != _tenants.end();
+  }
+
+  std::shared_ptr<ClientManager::Tenant> ClientManager::findTenant(const std::string &tenantId) const
+  {
+    std::lock_guard<std::mutex> lock(_tenantsMutex);
+    auto it = _tenants.find(tenantId);
+    if (it == _tenants.end())
+    {
+      throw std::invalid_argument("Unknown tenant: " + tenantId);
+    }
+    return it->second;
+  }
+
+  std::shared_ptr<Secrets::SecretsClient> ClientManager::secrets(const std::string &tenantId)
+  {
+    auto tenant = findTenant(tenantId);
+    // shares ownership of the whole tenant, the secrets client needs its HTTP and auth clients alive
+    return std::shared_ptr<Secrets::SecretsClient>(tenant, &tenant->secretsClient);
+  }
+
+  std::shared_ptr<const std::vector<Secrets::TSecret>> ClientManager::listSecrets(const std::string &tenantId, const Input::ListSecretsOptions &options)
+  {
+    // a cache hit wouldn't set them, and the variables of one process can't hold every tenant's secrets anyway
+    if (options.getAddSecretsToEnvironmentVariables())
+    {
+      throw std::invalid_argument("ClientManager::listSecrets() can't add secrets to environment variables, use secrets(tenantId)->listSecrets() instead");
+    }
+
+    auto tenant = findTenant(tenantId);
+    const auto key = listingKeyOf(options);
+
+    {
+      std::lock_guard<std::mutex> lock(_cacheMutex);
+      auto listing = tenant->listings.find(key);
+      if (listing != tenant->listings.end() && std::chrono::steady_clock::now() - listing->second.fetchedAt < _cacheTtl)
+      {
+        _recentlyUsed.splice(_recentlyUsed.begin(), _recentlyUsed, tenant->recentlyUsedPosition);
+        return listing->second.secrets;
+      }
+    }
+
+    const auto fetchedAt = std::chrono::steady_clock::now();
+    auto secrets = std::make_shared<const std::vector<Secrets::TSecret>>(tenant->secretsClient.listSecrets(options));
+    const auto size = approximateSize(*secrets) + key.capacity();
+
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    if (tenant->removed)
+    {
+      return secrets;
+    }
+
+    auto &listing = tenant->listings[key];
+    tenant->cacheSize = tenant->cacheSize - listing.size + size;
+    _cacheMemoryUsage = _cacheMemoryUsage - listing.size + size;
+    listing = Tenant::Listing{secrets, fetchedAt, size};
+
+    if (tenant->recentlyUsed)
+    {
+      _recentlyUsed.splice(_recentlyUsed.begin(), _recentlyUsed, tenant->recentlyUsedPosition);
+    }
+    else
+    {
+      tenant->recentlyUsedPosition = _recentlyUsed.insert(_recentlyUsed.begin(), tenant.get());
+      tenant->recentlyUsed = true;
+    }
+
+    evictLocked(tenant.get());
+    return secrets;
+  }
+
+  std::future<std::shared_ptr<const std::vector<Secrets::TSecret>>> ClientManager::listSecretsAsync(const std::string &tenantId, Input::ListSecretsOptions options)
+  {
+    return _workers.submit([this, tenantId, options = std::move(options)]()
+                           { return listSecrets(tenantId, options); });
+  }
+
+  void ClientManager::invalidate(const std::string &tenantId)
+  {
+    auto tenant = findTenant(tenantId);
+
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    dropListingsLocked(*tenant);
+  }
+
+  size_t ClientManager::cacheMemoryUsage() const
+  {
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    return _cacheMemoryUsage;
+  }
+
+  void ClientManager::dropListingsLocked(Tenant &tenant)
+  {
+    _cacheMemoryUsage -= tenant.cacheSize;
+    tenant.cacheSize = 0;
+    tenant.listings.clear();
+
+    if (tenant.recentlyUsed)
+    {
+      _recentlyUsed.erase(tenant.recentlyUsedPosition);
+      tenant.recentlyUsed = false;
+    }
+  }
+
+  void ClientManager::evictLocked(const Tenant *keep)
+  {
+    // the tenant that just stored a listing is kept even if it alone exceeds the limit, its caller is about to use it
+    while (_cacheMemoryUsage > _cacheMemoryLimit && !_recentlyUsed.empty())
+    {
+      auto *victim = _recentlyUsed.back();
+      if (victim == keep)
+      {
+        if (_recentlyUsed.size() == 1)
+        {
+          return;
+        }
+        victim = *std::prev(_recentlyUsed.end(), 2);
+      }
+      dropListingsLocked(*victim);
+    }
+  }
+
+  void ClientManager::prepareFork()
+  {
+    // worker tasks take the locks below, they have to be done before those are taken
+    _workers.prepareFork();
+    _tenantsMutex.lock();
+    for (auto &[id, tenant] : _tenants)
+    {
+      tenant->authClient.prepareFork();
+      tenant->secretsClient.prepareFork();
+    }
+    _cacheMutex.lock();
+    _share->prepareFork();
+  }
+
+  void ClientManager::afterForkInParent()
+  {
+    _share->afterForkInParent();
+    _cacheMutex.unlock();
+    for (auto &[id, tenant] : _tenants)
+    {
+      tenant->secretsClient.afterForkInParent();
+      tenant->authClient.afterForkInParent();
+    }
+    _tenantsMutex.unlock();
+    _workers.afterForkInParent();
+  }
+
+  void ClientManager::afterForkInChild()
+  {
+    _share->afterForkInChild();
+    _cacheMutex.unlock();
+    for (auto &[id, tenant] : _tenants)
+    {
+      tenant->secretsClient.afterForkInChild();
+      tenant->authClient.afterForkInChild();
+    }
+    _tenantsMutex.unlock();
+    _workers.afterForkInChild();
+  }
+
+}
@@ -0,0 +1,33 @@
+#include <libinfisical/InfisicalClient.h>
+
+namespace
+{
+  thread_local std::optional<std::chrono::steady_clock::time_point> currentDeadline;
+}
+
+namespace Infisical
+{
+
+  DeadlineScope::DeadlineScope(std::chrono::steady_clock::time_point deadline) : _previous(currentDeadline)
+  {
+    if (!currentDeadline || deadline < *currentDeadline)
+    {
+      currentDeadline = deadline;
+    }
+  }
+
+  DeadlineScope::DeadlineScope(std::chrono::milliseconds budget) : DeadlineScope(std::chrono::steady_clock::now() + budget)
+  {
+  }
+
+  DeadlineScope::~DeadlineScope()
+  {
+    currentDeadline = _previous;
+  }
+
+  std::optional<std::chrono::steady_clock::time_point> DeadlineScope::current()
+  {
+    return currentDeadline;
+  }
+
+}
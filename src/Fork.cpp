@@ -0,0 +1,104 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace
+{
+  // held from prepareFork() until the after-fork hooks, so nothing registers or unregisters across a fork
+  std::mutex &registryMutex()
+  {
+    static auto *mutex = new std::mutex();
+    return *mutex;
+  }
+
+  std::vector<Infisical::ForkAware *> &registry()
+  {
+    static auto *objects = new std::vector<Infisical::ForkAware *>();
+    return *objects;
+  }
+
+  thread_local bool inBackgroundTask = false;
+}
+
+namespace Infisical
+{
+
+  BackgroundTaskScope::BackgroundTaskScope() : _previous(inBackgroundTask)
+  {
+    inBackgroundTask = true;
+  }
+
+  BackgroundTaskScope::~BackgroundTaskScope()
+  {
+    inBackgroundTask = _previous;
+  }
+
+  bool BackgroundTaskScope::active()
+  {
+    return inBackgroundTask;
+  }
+
+  void ForkAware::registerForFork()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+  }
+
+  void ForkAware::unregisterForFork()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto &objects = registry();
+    objects.erase(std::remove(objects.begin(), objects.end(), this), objects.end());
+  }
+
+  void prepareFork()
+  {
+    // checked before anything is locked, so a caller that catches it has nothing to undo
+    if (BackgroundTaskScope::active())
+    {
+      throw std::logic_error("fork() can't be prepared from an SDK background thread, it would wait for the task it is running in");
+    }
+    registryMutex().lock();
+    for (auto *object : registry())
+    {
+      object->prepareFork();
+    }
+    // last, objects above may still allocate secure memory while they quiesce
+    secure::prepareFork();
+  }
+
+  void afterForkInParent()
+  {
+    secure::afterForkInParent();
+    auto &objects = registry();
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+    {
+      (*it)->afterForkInParent();
+    }
+    registryMutex().unlock();
+  }
+
+  void afterForkInChild()
+  {
+    secure::afterForkInChild();
+    auto &objects = registry();
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+    {
+      (*it)->afterForkInChild();
+    }
+    registryMutex().unlock();
+  }
+
+  void installForkHandlers()
+  {
+#ifndef _WIN32
+    static std::once_flag installed;
+    std::call_once(installed, []()
+                   { ::pthread_atfork(&Infisical::prepareFork, &Infisical::afterForkInParent, &Infisical::afterForkInChild); });
+#endif
+  }
+
+}
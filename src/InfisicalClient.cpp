@@ -3,27 +3,155 @@
 #include <iostream>
 #include <cpr/cpr.h>
 
+namespace
+{
+  constexpr std::chrono::seconds TOKEN_RENEWAL_RETRY_DELAY{30};
+}
+
 namespace Infisical
 {
 
-  InfisicalClient::InfisicalClient(Config &config) : _config(config), _httpClient(config.getUrl()), _authClient(config, &_httpClient), _secretsClient(&_httpClient)
+  InfisicalClient::InfisicalClient(Config &config)
+      : _config(config),
+        _httpClient(config.getUrl()),
+        _authClient(_config, &_httpClient),
+        _agentClient(_config.getAgentSocketPath().empty() ? nullptr : std::make_unique<agent::AgentClient>(_config.getAgentSocketPath())),
+        _secretsClient(&_httpClient, &_authClient, _agentClient.get())
   {
 
-    auto authentication = config.getAuthentication();
-    if (authentication._authStrategy == AuthStrategy::UNIVERSAL_AUTH)
+    if (_config.getAuthentication()._authStrategy != AuthStrategy::UNIVERSAL_AUTH)
+    {
+      throw std::invalid_argument("Unsupported authentication strategy");
+    }
+
+    _secretsClient.setMissingSecretCacheTtl(_config.getMissingSecretCacheTtl());
+
+    // before the first request, which may be the login below
+    _httpClient.setDnsCacheTimeout(_config.getDnsCacheTtl());
+    for (const auto &entry : _config.getResolveOverrides())
+    {
+      _httpClient.addResolveOverride(entry);
+    }
+    if (!_config.getCaBundle().empty())
     {
-      auto response = _authClient.universalAuthLogin(
-          authentication._clientId,
-          authentication._clientSecret);
-      _httpClient.setDefaultHeader("Authorization", "Bearer " + response.accessToken);
+      _httpClient.setCaBundle(_config.getCaBundle());
+    }
+    if (!_config.getRateLimits().empty())
+    {
+      auto limiter = std::make_shared<http::RateLimiter>();
+      for (const auto &limit : _config.getRateLimits())
+      {
+        limiter->setLimit(limit.endpointClass, limit.requestsPerSecond, limit.burst);
+      }
+      _httpClient.setRateLimiter(std::move(limiter));
+    }
+
+    if (_config.getTokenRenewal())
+    {
+      _scheduler = std::make_unique<RefreshScheduler>(_config.getRefreshJitter());
+      // every login, including the renewals themselves, schedules the next one from the lifetime of its token
+      _authClient.setLoginObserver([this](const auth::MachineIdentityLoginResponse &response)
+                                   {
+                                     if (response.expiresIn > 0)
+                                     {
+                                       scheduleTokenRenewal(std::chrono::seconds(response.expiresIn) * 3 / 4);
+                                     } });
+    }
+
+    if (_config.getDeferredLogin())
+    {
+      _authClient.startLogin();
     }
     else
     {
-      throw std::invalid_argument("Unsupported authentication strategy");
+      _authClient.login();
     }
+
+    registerForFork();
   }
 
   // Destructor implementation (needed for unique_ptr with incomplete type)
-  InfisicalClient::~InfisicalClient() = default;
+  InfisicalClient::~InfisicalClient()
+  {
+    unregisterForFork();
+    if (_scheduler)
+    {
+      _scheduler->stop();
+    }
+  }
+
+  void InfisicalClient::scheduleTokenRenewal(std::chrono::milliseconds delay)
+  {
+    _scheduler->scheduleOnce(delay, [this]()
+                             {
+                               try
+                               {
+                                 _authClient.renewLogin();
+                               }
+                               catch (...)
+                               {
+                                 // the current token is still valid for a while, keep trying until it isn't
+                                 scheduleTokenRenewal(TOKEN_RENEWAL_RETRY_DELAY);
+                               } });
+  }
+
+  void InfisicalClient::prepareFork()
+  {
+    // the login may still need every other part, it goes first
+    _authClient.prepareFork();
+    // after the login, which schedules its renewal when it's done. A renewal already running doesn't need the login lock
+    if (_scheduler)
+    {
+      _scheduler->prepareFork();
+    }
+    _secretsClient.prepareFork();
+    if (_agentClient)
+    {
+      _agentClient->prepareFork();
+    }
+    _httpClient.connectionShare().prepareFork();
+    if (auto *limiter = _httpClient.rateLimiter())
+    {
+      limiter->prepareFork();
+    }
+  }
+
+  void InfisicalClient::afterForkInParent()
+  {
+    if (auto *limiter = _httpClient.rateLimiter())
+    {
+      limiter->afterForkInParent();
+    }
+    _httpClient.connectionShare().afterForkInParent();
+    if (_agentClient)
+    {
+      _agentClient->afterForkInParent();
+    }
+    _secretsClient.afterForkInParent();
+    if (_scheduler)
+    {
+      _scheduler->afterForkInParent();
+    }
+    _authClient.afterForkInParent();
+  }
+
+  void InfisicalClient::afterForkInChild()
+  {
+    if (auto *limiter = _httpClient.rateLimiter())
+    {
+      limiter->afterForkInChild();
+    }
+    _httpClient.connectionShare().afterForkInChild();
+    if (_agentClient)
+    {
+      _agentClient->afterForkInChild();
+    }
+    _secretsClient.afterForkInChild();
+    if (_scheduler)
+    {
+      _scheduler->afterForkInChild();
+    }
+    _authClient.afterForkInChild();
+  }
 
 }
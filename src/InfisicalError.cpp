@@ -0,0 +1,101 @@
+#include <libinfisical/InfisicalClient.h>
+
+namespace Infisical
+{
+
+  struct InfisicalError::HttpDetails
+  {
+    std::string method;
+    std::string url;
+    std::string path;
+
+    std::once_flag parsed;
+    std::string requestId;
+    std::string serverMessage;
+    std::string what;
+  };
+
+  InfisicalError::InfisicalError(int statusCode, std::string method, std::string url, std::string path, std::string response)
+      : std::runtime_error(""),
+        m_statusCode(statusCode),
+        m_response(std::move(response)),
+        m_http(std::make_shared<HttpDetails>())
+  {
+    m_http->method = std::move(method);
+    m_http->url = std::move(url);
+    m_http->path = std::move(path);
+  }
+
+  const InfisicalError::HttpDetails &InfisicalError::parsedDetails() const
+  {
+    std::call_once(m_http->parsed, [this]()
+                   {
+                     auto &details = *m_http;
+                     bool hasMessage = false;
+
+                     // will always contain request ID if it contains a message
+                     auto json = nlohmann::json::parse(m_response, nullptr, false);
+                     if (json.is_object() && json.contains("message"))
+                     {
+                       const auto &message = json["message"];
+                       details.serverMessage = message.is_string()                         ? message.get<std::string>()
+                                               : (message.is_array() || message.is_object()) ? message.dump()
+                                                                                             : "Unknown error format";
+                       if (json.contains("reqId") && json["reqId"].is_string())
+                       {
+                         details.requestId = json["reqId"].get<std::string>();
+                       }
+                       hasMessage = true;
+                     }
+
+                     details.what = "HTTP Error: [url=" + details.url + "] [method=" + details.method + "] [status-code=" + std::to_string(m_statusCode) + "]";
+                     if (hasMessage)
+                     {
+                       details.what += " [request-id=" + (details.requestId.empty() ? std::string("Unknown") : details.requestId) + "] [message=" + details.serverMessage + "]";
+                     }
+                   });
+    return *m_http;
+  }
+
+  const char *InfisicalError::what() const noexcept
+  {
+    if (!m_http)
+    {
+      return std::runtime_error::what();
+    }
+
+    try
+    {
+      return parsedDetails().what.c_str();
+    }
+    catch (...)
+    {
+      return "HTTP Error";
+    }
+  }
+
+  const std::string &InfisicalError::getMethod() const
+  {
+    static const std::string none;
+    return m_http ? m_http->method : none;
+  }
+
+  const std::string &InfisicalError::getPath() const
+  {
+    static const std::string none;
+    return m_http ? m_http->path : none;
+  }
+
+  const std::string &InfisicalError::getRequestId() const
+  {
+    static const std::string none;
+    return m_http ? parsedDetails().requestId : none;
+  }
+
+  const std::string &InfisicalError::getServerMessage() const
+  {
+    static const std::string none;
+    return m_http ? parsedDetails().serverMessage : none;
+  }
+
+}
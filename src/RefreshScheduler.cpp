@@ -0,0 +1,274 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace Infisical
+{
+
+  RefreshScheduler::RefreshScheduler(double jitter, std::chrono::milliseconds tick, size_t slots)
+      : _jitter(jitter), _tick(tick), _start(std::chrono::steady_clock::now()), _wheel(slots), _random(std::random_device{}())
+  {
+    if (jitter < 0 || jitter >= 1)
+    {
+      throw std::invalid_argument("Refresh jitter must be at least 0 and less than 1");
+    }
+    if (tick.count() <= 0 || slots == 0)
+    {
+      throw std::invalid_argument("RefreshScheduler needs a positive tick and at least one slot");
+    }
+
+    _thread = std::thread([this]()
+                          { run(); });
+  }
+
+  RefreshScheduler::~RefreshScheduler()
+  {
+    stop();
+  }
+
+  RefreshScheduler::TaskId RefreshScheduler::scheduleEvery(std::chrono::milliseconds interval, std::function<void()> task)
+  {
+    if (interval.count() <= 0)
+    {
+      throw std::invalid_argument("Refresh interval must be positive");
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // spread over the whole first interval, that's where a fleet started together would otherwise line up
+    const auto delay = std::chrono::milliseconds(static_cast<int64_t>(interval.count() * randomFraction()));
+    return add(interval, true, delay, std::move(task));
+  }
+
+  RefreshScheduler::TaskId RefreshScheduler::scheduleOnce(std::chrono::milliseconds delay, std::function<void()> task)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto jittered = std::chrono::milliseconds(static_cast<int64_t>(delay.count() * (1 - _jitter * randomFraction())));
+    return add(delay, false, jittered, std::move(task));
+  }
+
+  RefreshScheduler::TaskId RefreshScheduler::add(std::chrono::milliseconds interval, bool repeating, std::chrono::milliseconds delay, std::function<void()> task)
+  {
+    if (_stopping)
+    {
+      return 0;
+    }
+
+    const auto id = _nextId++;
+    auto &entry = _tasks[id];
+    entry.interval = interval;
+    entry.repeating = repeating;
+    entry.run = std::make_shared<std::function<void()>>(std::move(task));
+    placeLocked(id, entry, delay);
+
+    // the thread sleeps without a deadline while the wheel is empty
+    if (_tasks.size() == 1)
+    {
+      _condition.notify_one();
+    }
+    return id;
+  }
+
+  void RefreshScheduler::placeLocked(TaskId id, Task &task, std::chrono::milliseconds delay)
+  {
+    const auto due = std::chrono::steady_clock::now() - _start + std::max(delay, std::chrono::milliseconds(0));
+    // rounded up, a task never runs before it's due
+    const auto dueTick = std::max<uint64_t>(static_cast<uint64_t>((due + _tick - std::chrono::nanoseconds(1)) / _tick), _currentTick + 1);
+
+    task.dueTick = dueTick;
+    _wheel[dueTick % _wheel.size()].push_back(SlotEntry{id, dueTick});
+  }
+
+  double RefreshScheduler::randomFraction()
+  {
+    return std::uniform_real_distribution<double>(0, 1)(_random);
+  }
+
+  void RefreshScheduler::cancel(TaskId id)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    // the slot entry stays behind and is skipped once the wheel gets to it
+    _tasks.erase(id);
+    if (std::this_thread::get_id() != _thread.get_id())
+    {
+      _idle.wait(lock, [this, id]()
+                 { return _running != id; });
+    }
+  }
+
+  void RefreshScheduler::stop()
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _stopping = true;
+      _tasks.clear();
+      for (auto &slot : _wheel)
+      {
+        slot.clear();
+      }
+    }
+    _condition.notify_all();
+
+    if (_thread.joinable() && std::this_thread::get_id() != _thread.get_id())
+    {
+      _thread.join();
+    }
+  }
+
+  void RefreshScheduler::run()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::vector<TaskId> due;
+    while (true)
+    {
+      _condition.wait(lock, [this]()
+                      { return _stopping || (!_paused && !_tasks.empty()); });
+      if (_stopping)
+      {
+        return;
+      }
+
+      const auto nextTick = _start + _tick * (_currentTick + 1);
+      if (_condition.wait_until(lock, nextTick, [this]()
+                                { return _stopping || _paused; }))
+      {
+        continue;
+      }
+
+      // after a stall every slot is visited at most once, an entry is due if its tick has passed whichever slot it's in
+      const auto nowTick = static_cast<uint64_t>((std::chrono::steady_clock::now() - _start) / _tick);
+      const auto visit = std::min<uint64_t>(nowTick - std::min(nowTick, _currentTick), _wheel.size());
+      for (uint64_t i = 1; i <= visit; i++)
+      {
+        auto &slot = _wheel[(_currentTick + i) % _wheel.size()];
+        for (size_t j = 0; j < slot.size();)
+        {
+          const auto entry = slot[j];
+          auto task = _tasks.find(entry.id);
+          const bool stale = task == _tasks.end() || task->second.dueTick != entry.dueTick;
+          if (stale || entry.dueTick <= nowTick)
+          {
+            if (!stale)
+            {
+              due.push_back(entry.id);
+            }
+            slot[j] = slot.back();
+            slot.pop_back();
+            continue;
+          }
+          j++;
+        }
+      }
+      _currentTick = std::max(_currentTick, nowTick);
+
+      for (const auto id : due)
+      {
+        auto task = _tasks.find(id);
+        // cancelled by a task that ran before it in this round
+        if (task == _tasks.end())
+        {
+          continue;
+        }
+        // a fork is waiting for the running task, this one goes at the next tick
+        if (_paused)
+        {
+          placeLocked(id, task->second, std::chrono::milliseconds(0));
+          continue;
+        }
+
+        auto fn = task->second.run;
+        _running = id;
+        lock.unlock();
+        try
+        {
+          BackgroundTaskScope background;
+          (*fn)();
+        }
+        catch (...)
+        {
+        }
+        lock.lock();
+        _running = 0;
+        _idle.notify_all();
+
+        // the task may have cancelled itself, or been replaced under the same id, while the lock was released
+        task = _tasks.find(id);
+        if (task == _tasks.end())
+        {
+          continue;
+        }
+        if (!task->second.repeating)
+        {
+          _tasks.erase(task);
+          continue;
+        }
+
+        const auto interval = task->second.interval.count();
+        const auto next = std::chrono::milliseconds(static_cast<int64_t>(interval * (1 + _jitter * (2 * randomFraction() - 1))));
+        placeLocked(id, task->second, next);
+      }
+      due.clear();
+    }
+  }
+
+  void RefreshScheduler::prepareFork()
+  {
+    if (std::this_thread::get_id() == _thread.get_id())
+    {
+      throw std::logic_error("RefreshScheduler::prepareFork() called from one of its own tasks, it would wait for itself");
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _paused = true;
+    _idle.wait(lock, [this]()
+               { return _running == 0; });
+    // stays locked across fork(), released by one of the after-fork hooks
+    lock.release();
+  }
+
+  void RefreshScheduler::afterForkInParent()
+  {
+    _paused = false;
+    _mutex.unlock();
+    _condition.notify_all();
+  }
+
+  void RefreshScheduler::afterForkInChild()
+  {
+    // same as WorkerPool: the handle refers to a thread of the parent and is leaked rather than destroyed joinable
+    new std::thread(std::move(_thread));
+    new (&_condition) std::condition_variable();
+    new (&_idle) std::condition_variable();
+
+    std::seed_seq seed{static_cast<uint64_t>(std::random_device{}()),
+#ifndef _WIN32
+                       static_cast<uint64_t>(::getpid()),
+#endif
+                       static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())};
+    _random.seed(seed);
+
+    // tasks the parent's thread had already taken off the wheel would otherwise never run again
+    for (auto &slot : _wheel)
+    {
+      slot.clear();
+    }
+    for (auto &[id, task] : _tasks)
+    {
+      task.dueTick = std::max(task.dueTick, _currentTick + 1);
+      _wheel[task.dueTick % _wheel.size()].push_back(SlotEntry{id, task.dueTick});
+    }
+
+    _paused = false;
+    _running = 0;
+    _mutex.unlock();
+
+    if (!_stopping)
+    {
+      _thread = std::thread([this]()
+                            { run(); });
+    }
+  }
+
+}
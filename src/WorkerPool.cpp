@@ -0,0 +1,129 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+
+namespace Infisical
+{
+
+  WorkerPool::WorkerPool(size_t threads)
+  {
+    if (threads == 0)
+    {
+      throw std::invalid_argument("WorkerPool needs at least one thread");
+    }
+
+    startThreads(threads);
+  }
+
+  void WorkerPool::startThreads(size_t count)
+  {
+    _threads.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      _threads.emplace_back([this]()
+                            { run(); });
+    }
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _condition.notify_all();
+
+    for (auto &thread : _threads)
+    {
+      thread.join();
+    }
+  }
+
+  void WorkerPool::enqueue(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _tasks.push_back(std::move(task));
+    }
+    _condition.notify_one();
+  }
+
+  void WorkerPool::run()
+  {
+    while (true)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this]()
+                        { return _stopping || (!_paused && !_tasks.empty()); });
+        // queued tasks still run on shutdown, their futures would otherwise never become ready
+        if (_tasks.empty())
+        {
+          return;
+        }
+        if (_paused)
+        {
+          continue;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+        _running++;
+      }
+
+      {
+        BackgroundTaskScope background;
+        task();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running--;
+      }
+      _idle.notify_all();
+    }
+  }
+
+  void WorkerPool::prepareFork()
+  {
+    const auto self = std::this_thread::get_id();
+    if (std::any_of(_threads.begin(), _threads.end(), [self](const std::thread &thread)
+                    { return thread.get_id() == self; }))
+    {
+      throw std::logic_error("WorkerPool::prepareFork() called from one of its own tasks, it would wait for itself");
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _paused = true;
+    _idle.wait(lock, [this]()
+               { return _running == 0; });
+    // stays locked across fork(), released by one of the after-fork hooks
+    lock.release();
+  }
+
+  void WorkerPool::afterForkInParent()
+  {
+    _paused = false;
+    _mutex.unlock();
+    _condition.notify_all();
+  }
+
+  void WorkerPool::afterForkInChild()
+  {
+    const auto count = _threads.size();
+
+    // the handles refer to threads of the parent, destroying them joinable would terminate, so they are moved out and leaked
+    new std::vector<std::thread>(std::move(_threads));
+    _threads.clear();
+    // waiters recorded in the condition variables were parent threads, start from fresh ones
+    new (&_condition) std::condition_variable();
+    new (&_idle) std::condition_variable();
+
+    _tasks.clear();
+    _paused = false;
+    _running = 0;
+    _mutex.unlock();
+
+    startThreads(count);
+  }
+
+}
@@ -0,0 +1,795 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+  // requests only carry a few identifiers, anything bigger is a confused or hostile peer
+  constexpr uint32_t AGENT_MAX_REQUEST_SIZE = 64 * 1024;
+  constexpr uint32_t AGENT_MAX_RESPONSE_SIZE = 1024 * 1024 * 1024;
+  constexpr int AGENT_IO_TIMEOUT_SECONDS = 5;
+  constexpr auto AGENT_IO_TIMEOUT = std::chrono::seconds(AGENT_IO_TIMEOUT_SECONDS);
+  // don't try to connect on every read while the agent is down
+  constexpr auto AGENT_RECONNECT_BACKOFF = std::chrono::seconds(1);
+
+  std::string normalizeSecretPath(const std::string &path)
+  {
+    if (path.empty())
+    {
+      return "/";
+    }
+
+    std::string normalized = path.front() == '/' ? path : "/" + path;
+    while (normalized.size() > 1 && normalized.back() == '/')
+    {
+      normalized.pop_back();
+    }
+    return normalized;
+  }
+
+  std::string scopeKeyOf(uint8_t flags, const std::string &projectId, const std::string &environment, const std::string &secretPath)
+  {
+    // \x1f (unit separator) can't appear in project IDs, environment slugs or paths
+    std::string key(1, static_cast<char>(flags));
+    key.append(projectId).append(1, '\x1f').append(environment).append(1, '\x1f').append(normalizeSecretPath(secretPath));
+    return key;
+  }
+
+  uint8_t flagsOf(const Infisical::Input::ListSecretsOptions &options)
+  {
+    return (options.getRecursive() ? Infisical::agent::AGENT_FLAG_RECURSIVE : 0) |
+           (options.getExpandSecretReferences() ? Infisical::agent::AGENT_FLAG_EXPAND_SECRET_REFERENCES : 0);
+  }
+
+  void appendU32(std::string &out, uint32_t value)
+  {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  void appendString(std::string &out, const std::string &value)
+  {
+    appendU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+  }
+
+  class RequestReader
+  {
+  public:
+    RequestReader(const char *data, size_t size) : _data(data), _size(size) {}
+
+    bool readU8(uint8_t &value)
+    {
+      if (_size - _pos < 1)
+      {
+        return false;
+      }
+      value = static_cast<uint8_t>(_data[_pos++]);
+      return true;
+    }
+
+    bool readString(std::string &value)
+    {
+      uint32_t length;
+      if (_size - _pos < sizeof(length))
+      {
+        return false;
+      }
+      std::memcpy(&length, _data + _pos, sizeof(length));
+      _pos += sizeof(length);
+      if (_size - _pos < length)
+      {
+        return false;
+      }
+      value.assign(_data + _pos, length);
+      _pos += length;
+      return true;
+    }
+
+    bool atEnd() const { return _pos == _size; }
+
+  private:
+    const char *_data;
+    size_t _size;
+    size_t _pos = 0;
+  };
+
+#ifndef _WIN32
+  bool sendAll(int fd, const char *data, size_t size)
+  {
+    size_t sent = 0;
+    while (sent < size)
+    {
+      auto n = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        return false;
+      }
+      sent += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool recvAll(int fd, char *data, size_t size)
+  {
+    size_t received = 0;
+    while (received < size)
+    {
+      auto n = ::recv(fd, data + received, size - received, 0);
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n <= 0)
+      {
+        return false;
+      }
+      received += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  // the client side blocks, with a timeout so a hung agent can't hold up a read for long
+  void configureSocket(int fd)
+  {
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    timeval timeout{AGENT_IO_TIMEOUT_SECONDS, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  }
+
+  // the server side never blocks, one slow client must not hold up the others
+  void configureServerSocket(int fd)
+  {
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  }
+
+  bool wouldBlock()
+  {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+
+  bool isSameUser(int fd)
+  {
+#ifdef SO_PEERCRED
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 && credentials.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return ::getpeereid(fd, &uid, &gid) == 0 && uid == ::geteuid();
+#endif
+  }
+
+  bool socketAddressOf(const std::string &path, sockaddr_un &address)
+  {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+      return false;
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return true;
+  }
+#endif
+}
+
+namespace Infisical
+{
+
+  namespace agent
+  {
+
+    // ---------------------------------------------------------------- client
+
+    AgentClient::AgentClient(std::string socketPath) : _socketPath(std::move(socketPath))
+    {
+    }
+
+    AgentClient::~AgentClient()
+    {
+      disconnect();
+    }
+
+    std::optional<Secrets::SecretSnapshot> AgentClient::listSecrets(const Input::ListSecretsOptions &options)
+    {
+      // the agent serves whole scopes, it can't apply a tag filter
+      if (!options.getTagSlugs().empty())
+      {
+        return std::nullopt;
+      }
+      return query(AgentOperation::LIST_SECRETS, flagsOf(options), options.getProjectId(), options.getEnvironment(), options.getSecretPath(), "");
+    }
+
+    std::optional<Secrets::SecretSnapshot> AgentClient::getSecret(const Input::GetSecretOptions &options)
+    {
+      // only the current version of shared secrets is held by the agent
+      if (options.getVersion() > 0 || (!options.getType().empty() && options.getType() != "shared"))
+      {
+        return std::nullopt;
+      }
+      const uint8_t flags = options.getExpandSecretReferences() ? AGENT_FLAG_EXPAND_SECRET_REFERENCES : 0;
+      return query(AgentOperation::GET_SECRET, flags, options.getProjectId(), options.getEnvironment(), options.getSecretPath(), options.getSecretKey());
+    }
+
+    bool AgentClient::connect()
+    {
+#ifdef _WIN32
+      return false;
+#else
+      if (std::chrono::steady_clock::now() < _retryAfter)
+      {
+        return false;
+      }
+
+      sockaddr_un address;
+      if (!socketAddressOf(_socketPath, address))
+      {
+        return false;
+      }
+
+      _fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (_fd >= 0)
+      {
+        configureSocket(_fd);
+        if (::connect(_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0)
+        {
+          return true;
+        }
+      }
+
+      disconnect();
+      _retryAfter = std::chrono::steady_clock::now() + AGENT_RECONNECT_BACKOFF;
+      return false;
+#endif
+    }
+
+    void AgentClient::prepareFork()
+    {
+      _mutex.lock();
+    }
+
+    void AgentClient::afterForkInParent()
+    {
+      _mutex.unlock();
+    }
+
+    void AgentClient::afterForkInChild()
+    {
+      // parent and child writing requests to one socket would interleave them
+      disconnect();
+      _retryAfter = {};
+      _mutex.unlock();
+    }
+
+    void AgentClient::disconnect()
+    {
+#ifndef _WIN32
+      if (_fd >= 0)
+      {
+        ::close(_fd);
+      }
+#endif
+      _fd = -1;
+    }
+
+    std::optional<Secrets::SecretSnapshot> AgentClient::query(
+        AgentOperation operation,
+        uint8_t flags,
+        const std::string &projectId,
+        const std::string &environment,
+        const std::string &secretPath,
+        const std::string &secretKey)
+    {
+#ifdef _WIN32
+      return std::nullopt;
+#else
+      std::string request;
+      appendU32(request, 0);
+      request.push_back(static_cast<char>(operation));
+      request.push_back(static_cast<char>(flags));
+      appendString(request, projectId);
+      appendString(request, environment);
+      appendString(request, secretPath);
+      appendString(request, secretKey);
+      const uint32_t length = static_cast<uint32_t>(request.size() - sizeof(uint32_t));
+      std::memcpy(&request[0], &length, sizeof(length));
+
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // a kept-alive connection may have been closed by an agent restart, requests are read-only so one retry on a fresh connection is safe
+      for (int attempt = 0; attempt < 2; attempt++)
+      {
+        if (_fd < 0 && !connect())
+        {
+          return std::nullopt;
+        }
+
+        char header[sizeof(uint32_t) + 1];
+        if (!sendAll(_fd, request.data(), request.size()) || !recvAll(_fd, header, sizeof(header)))
+        {
+          disconnect();
+          continue;
+        }
+
+        uint32_t responseLength;
+        std::memcpy(&responseLength, header, sizeof(responseLength));
+        const auto status = static_cast<AgentStatus>(header[sizeof(responseLength)]);
+        if (responseLength == 0 || responseLength > AGENT_MAX_RESPONSE_SIZE)
+        {
+          disconnect();
+          return std::nullopt;
+        }
+
+        SecretString payload(responseLength - 1, '\0');
+        if (!recvAll(_fd, &payload[0], payload.size()))
+        {
+          secure::wipe(payload);
+          disconnect();
+          return std::nullopt;
+        }
+
+        if (status != AgentStatus::OK)
+        {
+          return std::nullopt;
+        }
+
+        try
+        {
+          return Secrets::SecretSnapshot::fromBuffer(std::move(payload));
+        }
+        catch (const InfisicalError &)
+        {
+          // the stream can't be trusted to be in sync anymore
+          disconnect();
+          return std::nullopt;
+        }
+      }
+
+      return std::nullopt;
+#endif
+    }
+
+    // ---------------------------------------------------------------- server
+
+    struct AgentServer::Scope
+    {
+      std::vector<Secrets::TSecret> secrets;
+      std::unordered_map<std::string_view, size_t> byKey;
+      SecretString image;
+
+      ~Scope() { secure::wipe(image); }
+    };
+
+    // requests are read and responses written as far as the socket allows, the rest waits for the next poll() round
+    struct AgentServer::Connection
+    {
+      int fd;
+      std::string input;
+      std::chrono::steady_clock::time_point lastActivity;
+
+      // the response in flight: its header, then a payload held either by a scope or by ownedPayload
+      bool responding = false;
+      bool closeAfterResponse = false;
+      char header[sizeof(uint32_t) + 1];
+      std::string_view payload;
+      std::shared_ptr<const Scope> scope;
+      SecretString ownedPayload;
+      size_t sent = 0;
+
+      explicit Connection(int fd) : fd(fd), lastActivity(std::chrono::steady_clock::now()) {}
+      ~Connection() { secure::wipe(ownedPayload); }
+
+      void respond(AgentStatus status, std::string_view body)
+      {
+        const uint32_t length = static_cast<uint32_t>(body.size() + 1);
+        std::memcpy(header, &length, sizeof(length));
+        header[sizeof(length)] = static_cast<char>(status);
+        payload = body;
+        sent = 0;
+        responding = true;
+      }
+
+      bool busy() const { return responding || !input.empty(); }
+    };
+
+    AgentServer::AgentServer(InfisicalClient &client, std::string socketPath, std::vector<Input::ListSecretsOptions> scopes, std::chrono::seconds refreshInterval)
+        : _client(client), _socketPath(std::move(socketPath)), _scopeOptions(std::move(scopes)), _refreshInterval(refreshInterval)
+    {
+#ifndef _WIN32
+      // created up front so stop() works even before serve() is running
+      if (::pipe(_wakeFds) != 0)
+      {
+        throw InfisicalError(std::string("Failed to create agent wake-up pipe [error=") + std::strerror(errno) + "]", 0, "");
+      }
+      // both ends: stop() must never block, and the loop drains the pipe until it's empty
+      for (int fd : _wakeFds)
+      {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, O_NONBLOCK);
+      }
+#endif
+    }
+
+    AgentServer::~AgentServer()
+    {
+#ifndef _WIN32
+      ::close(_wakeFds[0]);
+      ::close(_wakeFds[1]);
+#endif
+    }
+
+    void AgentServer::setErrorHandler(std::function<void(const std::string &)> handler)
+    {
+      _errorHandler = std::move(handler);
+    }
+
+    void AgentServer::setRefreshJitter(double jitter)
+    {
+      if (!(jitter >= 0 && jitter < 1))
+      {
+        throw std::invalid_argument("Refresh jitter must be at least 0 and less than 1");
+      }
+      _refreshJitter = jitter;
+    }
+
+    bool AgentServer::refresh()
+    {
+      bool ok = true;
+      for (const auto &options : _scopeOptions)
+      {
+        ok = refreshScope(options) && ok;
+      }
+      return ok;
+    }
+
+    bool AgentServer::refreshScope(const Input::ListSecretsOptions &options)
+    {
+      const auto key = scopeKeyOf(flagsOf(options), options.getProjectId(), options.getEnvironment(), options.getSecretPath());
+
+      try
+      {
+        auto scope = std::make_shared<Scope>();
+        scope->secrets = _client.secrets().listSecrets(options);
+        scope->byKey.reserve(scope->secrets.size());
+        for (size_t i = 0; i < scope->secrets.size(); i++)
+        {
+          // last occurrence wins, same as the snapshot
+          scope->byKey[scope->secrets[i].getSecretKey()] = i;
+        }
+        scope->image = Secrets::SecretSnapshot::serialize(scope->secrets);
+
+        std::lock_guard<std::mutex> lock(_scopesMutex);
+        _scopes[key] = std::move(scope);
+        return true;
+      }
+      catch (const std::exception &e)
+      {
+        if (_errorHandler)
+        {
+          _errorHandler("Failed to refresh scope [project=" + options.getProjectId() + "] [environment=" + options.getEnvironment() + "] [path=" + options.getSecretPath() + "]: " + e.what());
+        }
+        return false;
+      }
+    }
+
+    std::shared_ptr<const AgentServer::Scope> AgentServer::findScope(const std::string &scopeKey)
+    {
+      std::lock_guard<std::mutex> lock(_scopesMutex);
+      auto it = _scopes.find(scopeKey);
+      return it == _scopes.end() ? nullptr : it->second;
+    }
+
+    void AgentServer::handle(Connection &connection, std::string_view request)
+    {
+      RequestReader reader(request.data(), request.size());
+      uint8_t operation, flags;
+      std::string projectId, environment, secretPath, secretKey;
+      if (!reader.readU8(operation) || !reader.readU8(flags) ||
+          !reader.readString(projectId) || !reader.readString(environment) ||
+          !reader.readString(secretPath) || !reader.readString(secretKey) || !reader.atEnd())
+      {
+        connection.respond(AgentStatus::ERROR, "Malformed request");
+        connection.closeAfterResponse = true;
+        return;
+      }
+
+      if (operation == static_cast<uint8_t>(AgentOperation::LIST_SECRETS))
+      {
+        connection.scope = findScope(scopeKeyOf(flags, projectId, environment, secretPath));
+        if (!connection.scope)
+        {
+          connection.respond(AgentStatus::UNKNOWN_SCOPE, "");
+          return;
+        }
+        connection.respond(AgentStatus::OK, std::string_view(connection.scope->image.data(), connection.scope->image.size()));
+        return;
+      }
+
+      if (operation == static_cast<uint8_t>(AgentOperation::GET_SECRET))
+      {
+        // a single secret always comes from a non-recursive listing of its own folder
+        auto scope = findScope(scopeKeyOf(flags & AGENT_FLAG_EXPAND_SECRET_REFERENCES, projectId, environment, secretPath));
+        if (!scope)
+        {
+          connection.respond(AgentStatus::UNKNOWN_SCOPE, "");
+          return;
+        }
+
+        auto it = scope->byKey.find(secretKey);
+        if (it == scope->byKey.end())
+        {
+          connection.respond(AgentStatus::NOT_FOUND, "");
+          return;
+        }
+
+        connection.ownedPayload = Secrets::SecretSnapshot::serialize({scope->secrets[it->second]});
+        connection.respond(AgentStatus::OK, std::string_view(connection.ownedPayload.data(), connection.ownedPayload.size()));
+        return;
+      }
+
+      connection.respond(AgentStatus::ERROR, "Unknown operation");
+    }
+
+    bool AgentServer::service(Connection &connection, short events)
+    {
+#ifdef _WIN32
+      return false;
+#else
+      if (events & (POLLERR | POLLNVAL))
+      {
+        return false;
+      }
+
+      // no reading while a response is pending, that bounds what a client that doesn't read its responses can make the agent buffer
+      if ((events & (POLLIN | POLLHUP)) && !connection.responding)
+      {
+        char chunk[4096];
+        while (connection.input.size() < sizeof(uint32_t) + AGENT_MAX_REQUEST_SIZE)
+        {
+          auto n = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+          if (n < 0 && errno == EINTR)
+          {
+            continue;
+          }
+          if (n < 0 && wouldBlock())
+          {
+            break;
+          }
+          if (n <= 0)
+          {
+            return false;
+          }
+          connection.input.append(chunk, static_cast<size_t>(n));
+          connection.lastActivity = std::chrono::steady_clock::now();
+        }
+      }
+
+      while (true)
+      {
+        if (!connection.responding)
+        {
+          uint32_t length;
+          if (connection.input.size() < sizeof(length))
+          {
+            return true;
+          }
+          std::memcpy(&length, connection.input.data(), sizeof(length));
+          if (length > AGENT_MAX_REQUEST_SIZE)
+          {
+            return false;
+          }
+          if (connection.input.size() - sizeof(length) < length)
+          {
+            return true;
+          }
+          handle(connection, std::string_view(connection.input.data() + sizeof(length), length));
+          connection.input.erase(0, sizeof(length) + length);
+        }
+
+        const size_t total = sizeof(connection.header) + connection.payload.size();
+        while (connection.sent < total)
+        {
+          const bool inHeader = connection.sent < sizeof(connection.header);
+          const char *data = inHeader ? connection.header + connection.sent : connection.payload.data() + (connection.sent - sizeof(connection.header));
+          const size_t size = inHeader ? sizeof(connection.header) - connection.sent : total - connection.sent;
+          auto n = ::send(connection.fd, data, size, MSG_NOSIGNAL);
+          if (n < 0 && errno == EINTR)
+          {
+            continue;
+          }
+          if (n < 0 && wouldBlock())
+          {
+            return true;
+          }
+          if (n < 0)
+          {
+            return false;
+          }
+          connection.sent += static_cast<size_t>(n);
+          connection.lastActivity = std::chrono::steady_clock::now();
+        }
+
+        connection.responding = false;
+        connection.payload = {};
+        connection.scope.reset();
+        secure::wipe(connection.ownedPayload);
+        if (connection.closeAfterResponse)
+        {
+          return false;
+        }
+      }
+#endif
+    }
+
+    void AgentServer::serve()
+    {
+#ifdef _WIN32
+      throw InfisicalError("The Infisical agent is not supported on Windows", 0, "");
+#else
+      sockaddr_un address;
+      if (!socketAddressOf(_socketPath, address))
+      {
+        throw InfisicalError("Invalid agent socket path [path=" + _socketPath + "]", 0, "");
+      }
+
+      // a socket left behind by a previous run is replaced, anything else at that path is not ours to delete
+      struct stat existing;
+      if (::lstat(_socketPath.c_str(), &existing) == 0)
+      {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+          throw InfisicalError("Agent socket path exists and is not a socket [path=" + _socketPath + "]", 0, "");
+        }
+        ::unlink(_socketPath.c_str());
+      }
+
+      int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (listenFd < 0)
+      {
+        throw InfisicalError(std::string("Failed to create agent socket [error=") + std::strerror(errno) + "]", 0, "");
+      }
+      // a client that goes away between poll() and accept() must not block the loop either
+      configureServerSocket(listenFd);
+
+      if (::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+          ::chmod(_socketPath.c_str(), 0600) != 0 ||
+          ::listen(listenFd, SOMAXCONN) != 0)
+      {
+        auto msg = std::string("Failed to listen on agent socket [path=") + _socketPath + "] [error=" + std::strerror(errno) + "]";
+        ::close(listenFd);
+        throw InfisicalError(msg, 0, "");
+      }
+
+      // refreshes run on the scheduler's thread, so slow API calls never hold up reads. Each scope has its own jittered due time,
+      // which spreads them over the interval instead of fetching every scope in one burst
+      RefreshScheduler refresher(_refreshJitter);
+      for (const auto &options : _scopeOptions)
+      {
+        refresher.scheduleEvery(_refreshInterval, [this, &options]()
+                                { refreshScope(options); });
+      }
+
+      // fds[i + 2] belongs to connections[i]
+      std::vector<pollfd> fds{{_wakeFds[0], POLLIN, 0}, {listenFd, POLLIN, 0}};
+      std::vector<std::unique_ptr<Connection>> connections;
+      auto closeConnection = [&fds, &connections](size_t i)
+      {
+        ::close(connections[i]->fd);
+        fds[i + 2] = fds.back();
+        fds.pop_back();
+        connections[i] = std::move(connections.back());
+        connections.pop_back();
+      };
+
+      while (!_stopping)
+      {
+        // idle connections wait indefinitely, a connection in the middle of a request or response is checked for a stall every second
+        const bool busy = std::any_of(connections.begin(), connections.end(), [](const auto &connection)
+                                      { return connection->busy(); });
+        if (::poll(fds.data(), fds.size(), busy ? 1000 : -1) < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          break;
+        }
+
+        if (fds[0].revents != 0)
+        {
+          char drain[64];
+          while (::read(_wakeFds[0], drain, sizeof(drain)) > 0)
+          {
+          }
+          continue;
+        }
+
+        // clients first, a new connection appended below must not be looked at in this round
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < connections.size();)
+        {
+          auto &connection = *connections[i];
+          const bool open = fds[i + 2].revents != 0 ? service(connection, fds[i + 2].revents) : !(connection.busy() && now - connection.lastActivity > AGENT_IO_TIMEOUT);
+          if (!open)
+          {
+            closeConnection(i);
+            continue;
+          }
+          fds[i + 2].events = connection.responding ? POLLOUT : POLLIN;
+          i++;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+          int clientFd = ::accept(listenFd, nullptr, nullptr);
+          if (clientFd >= 0)
+          {
+            if (isSameUser(clientFd))
+            {
+              configureServerSocket(clientFd);
+              fds.push_back({clientFd, POLLIN, 0});
+              connections.push_back(std::make_unique<Connection>(clientFd));
+            }
+            else
+            {
+              ::close(clientFd);
+            }
+          }
+        }
+      }
+
+      _stopping = true;
+      refresher.stop();
+
+      ::close(listenFd);
+      while (!connections.empty())
+      {
+        closeConnection(connections.size() - 1);
+      }
+      ::unlink(_socketPath.c_str());
+#endif
+    }
+
+    void AgentServer::stop()
+    {
+      _stopping = true;
+#ifndef _WIN32
+      const char wake = 1;
+      // the result doesn't matter, a full pipe already wakes the loop
+      auto written = ::write(_wakeFds[1], &wake, 1);
+      (void)written;
+#endif
+    }
+  }
+}
@@ -1,5 +1,18 @@
 #include <libinfisical/InfisicalClient.h>
 
+namespace
+{
+  // the parsed login response keeps its own copy of the token
+  void wipeAccessToken(nlohmann::json &response)
+  {
+    auto accessToken = response.is_object() ? response.find("accessToken") : response.end();
+    if (accessToken != response.end() && accessToken->is_string())
+    {
+      Infisical::secure::wipe(accessToken->get_ref<std::string &>());
+    }
+  }
+}
+
 namespace Infisical
 {
 
@@ -11,21 +24,228 @@ namespace Infisical
     {
     }
 
+    AuthClient::~AuthClient()
+    {
+      std::shared_future<void> pending;
+      {
+        std::lock_guard<std::mutex> lock(_loginMutex);
+        pending = _login;
+      }
+      if (pending.valid())
+      {
+        pending.wait();
+      }
+    }
+
     MachineIdentityLoginResponse AuthClient::universalAuthLogin(
         const std::string &clientId,
-        const std::string &clientSecret)
+        const SecretString &clientSecret)
     {
       nlohmann::json bodyJson = {
           {"clientId", clientId},
-          {"clientSecret", clientSecret}};
+          {"clientSecret", std::string(clientSecret.data(), clientSecret.size())}};
+      auto body = bodyJson.dump();
+      secure::wipe(*bodyJson["clientSecret"].get_ptr<std::string *>());
+
+      SecretString response;
+      try
+      {
+        httpClient->requestInto(http::Method::POST, "/api/v1/auth/universal-auth/login", response, {}, {}, body);
+      }
+      catch (...)
+      {
+        secure::wipe(body);
+        secure::wipe(response);
+        throw;
+      }
+      secure::wipe(body);
 
-      auto response = httpClient->post("/api/v1/auth/universal-auth/login", {}, bodyJson.dump());
-      auto parsedResponse = nlohmann::json::parse(response.text).get<MachineIdentityLoginResponse>();
+      nlohmann::json parsed;
+      try
+      {
+        parsed = nlohmann::json::parse(response.data(), response.data() + response.size());
+      }
+      catch (...)
+      {
+        secure::wipe(response);
+        throw;
+      }
+      secure::wipe(response);
 
-      httpClient->setDefaultHeader("Authorization", "Bearer " + parsedResponse.accessToken);
+      MachineIdentityLoginResponse parsedResponse;
+      try
+      {
+        parsedResponse = parsed.get<MachineIdentityLoginResponse>();
+      }
+      catch (...)
+      {
+        wipeAccessToken(parsed);
+        throw;
+      }
+      wipeAccessToken(parsed);
+
+      httpClient->setAccessToken(parsedResponse.accessToken);
 
       return parsedResponse;
     }
 
+    MachineIdentityLoginResponse AuthClient::login()
+    {
+      return login(true);
+    }
+
+    MachineIdentityLoginResponse AuthClient::renewLogin()
+    {
+      return login(false);
+    }
+
+    MachineIdentityLoginResponse AuthClient::login(bool reuseCachedToken)
+    {
+      auto authentication = config.getAuthentication();
+      if (authentication._authStrategy != AuthStrategy::UNIVERSAL_AUTH)
+      {
+        throw std::invalid_argument("Unsupported authentication strategy");
+      }
+
+      MachineIdentityLoginResponse response;
+      if (config.getTokenCachePath().empty())
+      {
+        response = universalAuthLogin(authentication._clientId, authentication._clientSecret);
+      }
+      else
+      {
+        TokenCache cache(config.getTokenCachePath(), config.getUrl(), authentication._clientId, authentication._clientSecret);
+        const auto loginNow = [&]()
+        { return universalAuthLogin(authentication._clientId, authentication._clientSecret); };
+        // the cache hands out a token until its last minute, a renewal would get the token it's meant to replace
+        response = reuseCachedToken ? cache.getOrLogin(loginNow) : cache.renew(loginNow);
+        // a token from the cache never went through universalAuthLogin(), which is what normally sets it
+        httpClient->setAccessToken(response.accessToken);
+      }
+
+      if (_onLogin)
+      {
+        _onLogin(response);
+      }
+      return response;
+    }
+
+    void AuthClient::setLoginObserver(std::function<void(const MachineIdentityLoginResponse &)> observer)
+    {
+      _onLogin = std::move(observer);
+    }
+
+    void AuthClient::startLoginLocked()
+    {
+      _loginAttempt++;
+      // the login runs on its own thread, where the caller's DeadlineScope wouldn't reach its request
+      _login = std::async(std::launch::async, [this, deadline = DeadlineScope::current()]()
+                          {
+                            // runs the login observer, which must not fork from here either
+                            BackgroundTaskScope background;
+                            std::optional<DeadlineScope> scope;
+                            if (deadline)
+                            {
+                              scope.emplace(*deadline);
+                            }
+                            login(); })
+                   .share();
+    }
+
+    void AuthClient::startLogin()
+    {
+      std::lock_guard<std::mutex> lock(_loginMutex);
+      _loginPending = true;
+      startLoginLocked();
+    }
+
+    void AuthClient::deferLogin()
+    {
+      std::lock_guard<std::mutex> lock(_loginMutex);
+      _loginPending = true;
+      _login = {};
+    }
+
+    void AuthClient::prepareFork()
+    {
+      // the login thread doesn't exist in the child, a login still running there would never finish. awaitLogin() can start a new one
+      // while we wait for the current one, so the lock is only kept once none is in flight
+      while (true)
+      {
+        std::unique_lock<std::mutex> lock(_loginMutex);
+        if (!_login.valid() || _login.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+          lock.release();
+          return;
+        }
+        auto pending = _login;
+        lock.unlock();
+        pending.wait();
+      }
+    }
+
+    void AuthClient::afterForkInParent()
+    {
+      _loginMutex.unlock();
+    }
+
+    void AuthClient::afterForkInChild()
+    {
+      _loginMutex.unlock();
+    }
+
+    void AuthClient::awaitLogin()
+    {
+      if (!_loginPending)
+      {
+        return;
+      }
+
+      std::shared_future<void> pending;
+      uint64_t attempt;
+      {
+        std::lock_guard<std::mutex> lock(_loginMutex);
+        if (!_loginPending)
+        {
+          return;
+        }
+        // the previous attempt failed, retry now instead of failing every call with the same error
+        if (!_login.valid())
+        {
+          startLoginLocked();
+        }
+        pending = _login;
+        attempt = _loginAttempt;
+      }
+
+      // a login started by a call without a deadline keeps running, this caller just stops waiting for it
+      const auto deadline = DeadlineScope::current();
+      if (deadline && pending.wait_until(*deadline) != std::future_status::ready)
+      {
+        throw InfisicalError("Deadline exceeded waiting for the login", 0, "");
+      }
+
+      try
+      {
+        pending.get();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(_loginMutex);
+        if (attempt == _loginAttempt)
+        {
+          _login = {};
+        }
+        throw;
+      }
+
+      std::lock_guard<std::mutex> lock(_loginMutex);
+      if (attempt == _loginAttempt)
+      {
+        _loginPending = false;
+        _login = {};
+      }
+    }
+
   }
 }
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include <libinfisical/InfisicalClient.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // tokens closer than this to expiring are treated as expired, so a cached token doesn't run out mid-request
+  constexpr int64_t TOKEN_CACHE_MIN_REMAINING_SECONDS = 60;
+
+  int64_t nowSeconds()
+  {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  void fnv1a(uint64_t &hash, std::string_view data)
+  {
+    for (unsigned char c : data)
+    {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    // separator, so ("ab", "c") and ("a", "bc") hash differently
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+  }
+
+#ifndef _WIN32
+  // closes the descriptor and releases any flock() held through it
+  class FileDescriptor
+  {
+  public:
+    explicit FileDescriptor(int fd) : _fd(fd) {}
+    ~FileDescriptor()
+    {
+      if (_fd >= 0)
+      {
+        ::close(_fd);
+      }
+    }
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    int get() const { return _fd; }
+    bool valid() const { return _fd >= 0; }
+
+  private:
+    int _fd;
+  };
+
+  // a cache another user could have written (or can read) is never trusted
+  bool isPrivateFile(int fd)
+  {
+    struct stat info;
+    return ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_uid == ::geteuid() && (info.st_mode & 077) == 0;
+  }
+
+  bool writeAll(int fd, const std::string &data)
+  {
+    size_t written = 0;
+    while (written < data.size())
+    {
+      auto n = ::write(fd, data.data() + written, data.size() - written);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        return false;
+      }
+      written += static_cast<size_t>(n);
+    }
+    return true;
+  }
+#endif
+}
+
+namespace Infisical
+{
+
+  namespace auth
+  {
+
+    TokenCache::TokenCache(std::string path, const std::string &hostUrl, const std::string &clientId, const SecretString &clientSecret)
+        : _path(std::move(path))
+    {
+      // the secret is part of the identity so rotating it invalidates the cache, but only its hash ever reaches the file
+      uint64_t hash = 14695981039346656037ULL;
+      fnv1a(hash, hostUrl);
+      fnv1a(hash, clientId);
+      fnv1a(hash, std::string_view(clientSecret.data(), clientSecret.size()));
+
+      char hex[17];
+      std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+      _identity = hex;
+    }
+
+    std::optional<MachineIdentityLoginResponse> TokenCache::load() const
+    {
+#ifdef _WIN32
+      return std::nullopt;
+#else
+      FileDescriptor fd(::open(_path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+      if (!fd.valid() || !isPrivateFile(fd.get()))
+      {
+        return std::nullopt;
+      }
+
+      std::string content;
+      char buffer[4096];
+      while (true)
+      {
+        auto n = ::read(fd.get(), buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (n <= 0)
+        {
+          break;
+        }
+        content.append(buffer, static_cast<size_t>(n));
+      }
+      secure::wipe(buffer, sizeof(buffer));
+
+      std::optional<MachineIdentityLoginResponse> result;
+      try
+      {
+        auto parsed = nlohmann::json::parse(content);
+        secure::wipe(content);
+
+        const auto remaining = parsed.at("expiresAt").get<int64_t>() - nowSeconds();
+        if (parsed.at("identity").get_ref<const std::string &>() == _identity && remaining > TOKEN_CACHE_MIN_REMAINING_SECONDS)
+        {
+          result = parsed.at("token").get<MachineIdentityLoginResponse>();
+          result->expiresIn = static_cast<int>(remaining);
+        }
+        secure::wipe(parsed.at("token").at("accessToken").get_ref<std::string &>());
+      }
+      catch (const nlohmann::json::exception &)
+      {
+        // a corrupt or outdated cache file is the same as no cache file
+        secure::wipe(content);
+        return std::nullopt;
+      }
+
+      return result;
+#endif
+    }
+
+    void TokenCache::store(const MachineIdentityLoginResponse &response) const
+    {
+#ifndef _WIN32
+      nlohmann::json entry = {
+          {"identity", _identity},
+          {"expiresAt", nowSeconds() + response.expiresIn},
+          {"token", response}};
+      auto content = entry.dump();
+      secure::wipe(*entry["token"]["accessToken"].get_ptr<std::string *>());
+
+      // written next to the cache and renamed over it, so readers see either the old or the new file, never a partial one
+      const auto temporaryPath = _path + ".tmp." + std::to_string(::getpid());
+      bool written = false;
+      {
+        FileDescriptor fd(::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600));
+        written = fd.valid() && ::fchmod(fd.get(), 0600) == 0 && writeAll(fd.get(), content) && ::fsync(fd.get()) == 0;
+      }
+      secure::wipe(content);
+
+      if (!written || std::rename(temporaryPath.c_str(), _path.c_str()) != 0)
+      {
+        ::unlink(temporaryPath.c_str());
+      }
+#endif
+    }
+
+    MachineIdentityLoginResponse TokenCache::getOrLogin(const std::function<MachineIdentityLoginResponse()> &login) const
+    {
+      if (auto cached = load())
+      {
+        return *cached;
+      }
+
+#ifdef _WIN32
+      return login();
+#else
+      // serialize logins per cache file, everyone queued behind the process that logs in reuses its token
+      const auto lockPath = _path + ".lock";
+      FileDescriptor lock(::open(lockPath.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600));
+      if (!lock.valid() || ::flock(lock.get(), LOCK_EX) != 0)
+      {
+        return login();
+      }
+
+      if (auto cached = load())
+      {
+        return *cached;
+      }
+
+      auto response = login();
+      store(response);
+      return response;
+#endif
+    }
+
+    MachineIdentityLoginResponse TokenCache::renew(const std::function<MachineIdentityLoginResponse()> &login) const
+    {
+#ifdef _WIN32
+      return login();
+#else
+      const auto lockPath = _path + ".lock";
+      FileDescriptor lock(::open(lockPath.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600));
+      if (!lock.valid() || ::flock(lock.get(), LOCK_EX) != 0)
+      {
+        return login();
+      }
+
+      auto response = login();
+      store(response);
+      return response;
+#endif
+    }
+
+  }
+}
@@ -13,7 +13,8 @@ namespace Infisical
   {
     _authentication._authStrategy = AuthStrategy::UNIVERSAL_AUTH;
     _authentication._clientId = std::move(clientId);
-    _authentication._clientSecret = std::move(clientSecret);
+    _authentication._clientSecret.assign(clientSecret.data(), clientSecret.size());
+    secure::wipe(clientSecret);
     return *this;
   }
 
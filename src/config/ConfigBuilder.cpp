@@ -1,4 +1,6 @@
 #include "libinfisical/InfisicalClient.h"
+#include <algorithm>
+#include <cctype>
 
 namespace Infisical
 {
@@ -15,6 +17,117 @@ namespace Infisical
     return *this;
   }
 
+  /*
+   * Share login tokens with other processes using the same identity through a cache file. The file is created with 0600 permissions.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withTokenCacheFile(std::string path)
+  {
+    config_.tokenCachePath_ = std::move(path);
+    return *this;
+  }
+
+  /*
+   * Log in on a background thread instead of in the InfisicalClient constructor. The first secrets call waits for the login if it's still in flight.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withDeferredLogin(bool deferredLogin)
+  {
+    config_.deferredLogin_ = deferredLogin;
+    return *this;
+  }
+
+  /*
+   * Read secrets from a local `infisical_agent` listening on `socketPath` before going to the API. Reads the agent can't answer fall back to the API.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withAgentSocket(std::string socketPath)
+  {
+    config_.agentSocketPath_ = std::move(socketPath);
+    return *this;
+  }
+
+  /*
+   * Remember secrets `tryGetSecret()` found missing for `ttl`, so probing for an optional secret doesn't repeat the request every time.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withMissingSecretCacheTtl(std::chrono::milliseconds ttl)
+  {
+    config_.missingSecretCacheTtl_ = ttl;
+    return *this;
+  }
+
+  /*
+   * Keep resolved host names for `ttl` in the DNS cache shared by all requests of the client. A negative TTL caches them forever.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withDnsCacheTtl(std::chrono::seconds ttl)
+  {
+    config_.dnsCacheTtl_ = ttl;
+    return *this;
+  }
+
+  /*
+   * Pin a host to fixed addresses, e.g. "app.infisical.com:443:10.0.0.5". Can be called more than once.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withResolveOverride(std::string entry)
+  {
+    // host:port:address[,address]..., addresses may be bracketed IPv6 and contain colons themselves
+    const auto hostEnd = entry.find(':');
+    const auto portEnd = hostEnd == std::string::npos ? std::string::npos : entry.find(':', hostEnd + 1);
+    const bool validPort = portEnd != std::string::npos && portEnd > hostEnd + 1 &&
+                           std::all_of(entry.begin() + hostEnd + 1, entry.begin() + portEnd, [](unsigned char c)
+                                       { return std::isdigit(c); });
+    if (hostEnd == 0 || !validPort || portEnd + 1 >= entry.size())
+    {
+      throw std::invalid_argument("Resolve override must have the form host:port:address, got: " + entry);
+    }
+
+    config_.resolveOverrides_.push_back(std::move(entry));
+    return *this;
+  }
+
+  /*
+   * PEM file with the CA certificates the server is verified against, replacing the system store.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withCaBundle(std::string path)
+  {
+    config_.caBundle_ = std::move(path);
+    return *this;
+  }
+
+  /*
+   * Limit requests to an endpoint class to `requestsPerSecond` on average, in bursts of up to `burst`. Calls over the limit wait in line.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withRateLimit(http::EndpointClass endpointClass, double requestsPerSecond, size_t burst)
+  {
+    if (!(requestsPerSecond > 0) || burst == 0)
+    {
+      throw std::invalid_argument("Rate limit must allow a positive number of requests per second and a burst of at least 1");
+    }
+
+    config_.rateLimits_.push_back(http::RateLimit{endpointClass, requestsPerSecond, burst});
+    return *this;
+  }
+
+  /*
+   * Log in again in the background before the access token expires, at about three quarters of its lifetime.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withTokenRenewal(bool tokenRenewal)
+  {
+    config_.tokenRenewal_ = tokenRenewal;
+    return *this;
+  }
+
+  /*
+   * Fraction of a refresh interval by which background refreshes are moved at random, so a fleet started together doesn't refresh together.
+   */
+  Infisical::ConfigBuilder &ConfigBuilder::withRefreshJitter(double jitter)
+  {
+    if (!(jitter >= 0 && jitter < 1))
+    {
+      throw std::invalid_argument("Refresh jitter must be at least 0 and less than 1");
+    }
+
+    config_.refreshJitter_ = jitter;
+    return *this;
+  }
+
   Infisical::Config &ConfigBuilder::build()
   {
 
@@ -23,6 +136,11 @@ namespace Infisical
       throw std::invalid_argument("Config URL cannot be empty");
     }
 
+    if (config_.missingSecretCacheTtl_.count() < 0)
+    {
+      throw std::invalid_argument("Missing secret cache TTL cannot be negative");
+    }
+
     if (config_.url_.size() >= 4 && config_.url_.substr(config_.url_.size() - 4) == "/api")
     {
       config_.url_ = config_.url_.substr(0, config_.url_.size() - 4);
@@ -0,0 +1,81 @@
+#include <libinfisical/InfisicalClient.h>
+#include <stdexcept>
+
+namespace Infisical
+{
+
+  namespace http
+  {
+
+    ConnectionShare::ConnectionShare() : m_handle(createHandle())
+    {
+    }
+
+    CURLSH *ConnectionShare::createHandle()
+    {
+      CURLSH *handle = curl_share_init();
+      if (handle == nullptr)
+      {
+        throw std::runtime_error("Failed to initialize libcurl share handle");
+      }
+
+      curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, &ConnectionShare::lock);
+      curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, &ConnectionShare::unlock);
+      curl_share_setopt(handle, CURLSHOPT_USERDATA, this);
+      curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+      // one resolver cache for every request, a fresh session doesn't mean a fresh lookup
+      curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      // a new connection resumes an earlier TLS session (or presents its ticket) instead of a full handshake with chain verification
+      curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+      return handle;
+    }
+
+    ConnectionShare::~ConnectionShare()
+    {
+      curl_share_cleanup(m_handle);
+    }
+
+    void ConnectionShare::attach(cpr::Session &session) const
+    {
+      curl_easy_setopt(session.GetCurlHolder()->handle, CURLOPT_SHARE, m_handle);
+    }
+
+    void ConnectionShare::prepareFork()
+    {
+      // no transfer is inside the share while all its locks are held
+      for (auto &mutex : m_locks)
+      {
+        mutex.lock();
+      }
+    }
+
+    void ConnectionShare::afterForkInParent()
+    {
+      for (auto &mutex : m_locks)
+      {
+        mutex.unlock();
+      }
+    }
+
+    void ConnectionShare::afterForkInChild()
+    {
+      for (auto &mutex : m_locks)
+      {
+        mutex.unlock();
+      }
+      // the parent's connections stay open in the inherited handle, which is intentionally leaked
+      m_handle = createHandle();
+    }
+
+    void ConnectionShare::lock(CURL *, curl_lock_data data, curl_lock_access, void *userptr)
+    {
+      static_cast<ConnectionShare *>(userptr)->m_locks[data].lock();
+    }
+
+    void ConnectionShare::unlock(CURL *, curl_lock_data data, void *userptr)
+    {
+      static_cast<ConnectionShare *>(userptr)->m_locks[data].unlock();
+    }
+
+  } // namespace http
+}
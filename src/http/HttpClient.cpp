@@ -1,4 +1,5 @@
 #include "libinfisical/InfisicalClient.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
@@ -22,13 +23,30 @@ std::string httpMethodStringRepresentation(Infisical::http::Method method)
   }
 }
 
+namespace
+{
+  // per-thread scratch for building requests. Copy-assigning a map reuses its nodes and assigning a string reuses its capacity,
+  // so once a thread has sent a request the URL and headers of the next one don't allocate
+  struct RequestScratch
+  {
+    std::string url;
+    cpr::Header headers;
+  };
+
+  RequestScratch &requestScratch()
+  {
+    thread_local RequestScratch scratch;
+    return scratch;
+  }
+}
+
 namespace Infisical
 {
 
   namespace http
   {
 
-    HttpClient::HttpClient() : m_timeout(30000)
+    HttpClient::HttpClient() : m_timeout(30000), m_share(std::make_shared<ConnectionShare>())
     {
       // Set some sensible defaults
       m_defaultHeaders["User-Agent"] = "infisical-cpp-sdk";
@@ -41,6 +59,11 @@ namespace Infisical
       m_baseUrl = baseUrl;
     }
 
+    HttpClient::HttpClient(const std::string &baseUrl, std::shared_ptr<ConnectionShare> share) : HttpClient(baseUrl)
+    {
+      m_share = std::move(share);
+    }
+
     void HttpClient::setBaseUrl(const std::string &baseUrl)
     {
       m_baseUrl = baseUrl;
@@ -51,14 +74,55 @@ namespace Infisical
       m_defaultHeaders[name] = value;
     }
 
-    cpr::Header HttpClient::mergeHeaders(const std::map<std::string, std::string> &headers)
+    void HttpClient::setDnsCacheTimeout(std::chrono::seconds timeout)
     {
-      cpr::Header merged;
+      m_dnsCacheTimeout = timeout.count() < 0 ? -1 : static_cast<long>(timeout.count());
+    }
 
-      // Add default headers
-      for (const auto &[key, value] : m_defaultHeaders)
+    void HttpClient::addResolveOverride(const std::string &entry)
+    {
+      curl_slist *list = curl_slist_append(m_resolveOverrides.get(), entry.c_str());
+      if (list == nullptr)
       {
-        merged[key] = value;
+        throw std::bad_alloc();
+      }
+      // append returns the head, which only changes for the first entry
+      m_resolveOverrides.release();
+      m_resolveOverrides.reset(list);
+    }
+
+    void HttpClient::setCaBundle(const std::string &path)
+    {
+      m_caBundle = path;
+    }
+
+    void HttpClient::setRateLimiter(std::shared_ptr<RateLimiter> limiter)
+    {
+      m_rateLimiter = std::move(limiter);
+    }
+
+    void HttpClient::setAccessToken(std::string_view accessToken)
+    {
+      static constexpr std::string_view prefix = "Bearer ";
+
+      std::lock_guard<std::mutex> lock(m_authorizationMutex);
+      secure::wipe(m_authorizationHeader);
+      m_authorizationHeader.reserve(prefix.size() + accessToken.size());
+      m_authorizationHeader.append(prefix.data(), prefix.size());
+      m_authorizationHeader.append(accessToken.data(), accessToken.size());
+    }
+
+    void HttpClient::mergeHeaders(const std::map<std::string, std::string> &headers, cpr::Header &merged)
+    {
+      // Start from the default headers
+      merged = m_defaultHeaders;
+
+      {
+        std::lock_guard<std::mutex> lock(m_authorizationMutex);
+        if (!m_authorizationHeader.empty())
+        {
+          merged["Authorization"].assign(m_authorizationHeader.data(), m_authorizationHeader.size());
+        }
       }
 
       // Add (or override) with request-specific headers
@@ -66,8 +130,6 @@ namespace Infisical
       {
         merged[key] = value;
       }
-
-      return merged;
     }
 
     cpr::Parameters HttpClient::convertParams(const std::map<std::string, std::string> &params)
@@ -82,18 +144,17 @@ namespace Infisical
       return cprParams;
     }
 
-    cpr::Response HttpClient::request(
+    cpr::Response HttpClient::perform(
         Method method,
-        const std::string &endpoint,
+        const std::string &url,
         const std::map<std::string, std::string> &headers,
         const std::map<std::string, std::string> &params,
-        const std::string &body)
+        const std::string &body,
+        const std::function<bool(std::string_view)> *onBody)
     {
-      // Prepare the URL
-      std::string url = m_baseUrl + endpoint;
-
       // Prepare headers and parameters
-      cpr::Header mergedHeaders = mergeHeaders(headers);
+      auto &mergedHeaders = requestScratch().headers;
+      mergeHeaders(headers, mergedHeaders);
       cpr::Parameters cprParams = convertParams(params);
 
       // Create a session
@@ -101,7 +162,27 @@ namespace Infisical
       session.SetUrl(url);
       session.SetHeader(mergedHeaders);
       session.SetParameters(cprParams);
-      session.SetTimeout(m_timeout);
+      // a deadline only ever shortens the configured timeout. admit() already failed calls whose deadline has passed
+      long timeout = m_timeout;
+      if (const auto deadline = DeadlineScope::current())
+      {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count();
+        timeout = std::max<long>(1, std::min<long>(timeout, static_cast<long>(remaining)));
+      }
+      session.SetTimeout(timeout);
+      m_share->attach(session);
+
+      // resolved addresses live in the share's DNS cache, so this only decides how long they stay valid there
+      CURL *curl = session.GetCurlHolder()->handle;
+      curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, m_dnsCacheTimeout);
+      if (m_resolveOverrides)
+      {
+        curl_easy_setopt(curl, CURLOPT_RESOLVE, m_resolveOverrides.get());
+      }
+      if (!m_caBundle.empty())
+      {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, m_caBundle.c_str());
+      }
 
       // Set body for appropriate methods
       if (!body.empty() && (method == Method::POST || method == Method::PATCH || method == Method::DELETE))
@@ -109,6 +190,27 @@ namespace Infisical
         session.SetBody(body);
       }
 
+      // error bodies are kept apart so they still end up in the error message instead of in the caller's sink
+      std::string errorBody;
+      if (onBody != nullptr)
+      {
+        int state = 0; // 0 = status not checked yet, 1 = forwarding, 2 = collecting an error body
+        session.SetWriteCallback(cpr::WriteCallback([handle = curl, onBody, &errorBody, state](const std::string_view &data, intptr_t) mutable
+                                                    {
+                                                      if (state == 0)
+                                                      {
+                                                        long status = 0;
+                                                        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+                                                        state = status >= 200 && status < 400 ? 1 : 2;
+                                                      }
+                                                      if (state == 2)
+                                                      {
+                                                        errorBody.append(data.data(), data.size());
+                                                        return true;
+                                                      }
+                                                      return (*onBody)(data); }));
+      }
+
       // Execute the request based on the method
       cpr::Response response;
 
@@ -130,114 +232,122 @@ namespace Infisical
         throw std::invalid_argument("Invalid HTTP method");
       }
 
+      // the scratch header map holds a plain copy of the token, don't leave it there until the next request
+      auto authorization = mergedHeaders.find("Authorization");
+      if (authorization != mergedHeaders.end())
+      {
+        secure::wipe(authorization->second);
+      }
+
+      if (onBody != nullptr)
+      {
+        response.text = std::move(errorBody);
+      }
+
+      return response;
+    }
+
+    std::optional<InfisicalError> HttpClient::checkResponse(Method method, const std::string &url, const std::string &endpoint, cpr::Response &response)
+    {
       // note(daniel): should probably also check for status code = 0 here, because status code will be 0 if there was a network error
       if (response.error)
       {
-        throw Infisical::InfisicalError("Network error: " + response.error.message, 0, "");
+        return InfisicalError("Network error: " + response.error.message, 0, "");
       }
 
-      std::string errorMsg = "";
       if (response.status_code < 200 || response.status_code >= 400)
       {
-        nlohmann::json jsonResponse;
-        try
-        {
-          jsonResponse = nlohmann::json::parse(response.text);
-
-          std::string errorMessageStr;
-
-          // will always contain request ID if it contains a message
-          if (jsonResponse.contains("message"))
-          {
-
-            std::string reqId = jsonResponse.contains("reqId") ? jsonResponse["reqId"].get<std::string>() : "Unknown";
-            errorMessageStr =
-                jsonResponse["message"].is_string()                                           ? jsonResponse["message"].get<std::string>()
-                : (jsonResponse["message"].is_array() || jsonResponse["message"].is_object()) ? jsonResponse["message"].dump()
-                                                                                              : "Unknown error format";
-            int requiredBufferSize = snprintf(
-                nullptr,
-                0,
-                "HTTP Error: [url=%s] [method=%s] [status-code=%ld] [request-id=%s] [message=%s]",
-                url.c_str(),
-                httpMethodStringRepresentation(method).c_str(),
-                response.status_code,
-                reqId.c_str(),
-                errorMessageStr.c_str());
-
-            std::vector<char> buffer(requiredBufferSize + 1);
-            snprintf(
-                buffer.data(),
-                buffer.size(),
-                "HTTP Error: [url=%s] [method=%s] [status-code=%ld] [request-id=%s] [message=%s]",
-                url.c_str(),
-                httpMethodStringRepresentation(method).c_str(),
-                response.status_code,
-                reqId.c_str(),
-                errorMessageStr.c_str());
-
-            std::string msg(buffer.data(), buffer.size() - 1);
-            throw Infisical::InfisicalError(msg, response.status_code, response.text);
-          }
-        }
-        catch (const nlohmann::json::exception &e)
-        {
+        // the body is only parsed if someone asks the error for its details
+        return InfisicalError(static_cast<int>(response.status_code), httpMethodStringRepresentation(method), url, endpoint, std::move(response.text));
+      }
 
-          int requiredBufferSize = snprintf(
-              nullptr,
-              0,
-              "HTTP Error: [url=%s] [method=%s] [status-code=%ld]",
-              url.c_str(),
-              httpMethodStringRepresentation(method).c_str(),
-              response.status_code);
-
-          std::vector<char> buffer(requiredBufferSize + 1);
-
-          snprintf(
-              buffer.data(),
-              buffer.size(),
-              "HTTP Error: [url=%s] [method=%s] [status-code=%ld]",
-              url.c_str(),
-              httpMethodStringRepresentation(method).c_str(),
-              response.status_code);
-
-          errorMsg = std::string(buffer.data(), buffer.size() - 1);
-        }
-        catch (const Infisical::InfisicalError &)
-        {
-          // rethrow the infisical error
-          throw;
-        }
-        catch (...)
-        {
+      return std::nullopt;
+    }
 
-          int requiredBufferSize = snprintf(
-              nullptr,
-              0,
-              "HTTP Error: [url=%s] [method=%s] [status-code=%ld]",
-              url.c_str(),
-              httpMethodStringRepresentation(method).c_str(),
-              response.status_code);
-
-          std::vector<char> buffer(requiredBufferSize + 1);
-
-          snprintf(
-              buffer.data(),
-              buffer.size(),
-              "HTTP Error: [url=%s] [method=%s] [status-code=%ld]",
-              url.c_str(),
-              httpMethodStringRepresentation(method).c_str(),
-              response.status_code);
-
-          errorMsg = std::string(buffer.data(), buffer.size() - 1);
-        }
+    std::optional<InfisicalError> HttpClient::admit(const std::string &endpoint)
+    {
+      // an expired call must not take a token a live one could have used
+      const auto deadline = DeadlineScope::current();
+      if (deadline && std::chrono::steady_clock::now() >= *deadline)
+      {
+        return InfisicalError("Deadline exceeded before sending " + endpoint, 0, "");
+      }
+      if (m_rateLimiter && !m_rateLimiter->acquire(RateLimiter::classify(endpoint), deadline))
+      {
+        return InfisicalError("Rate limited: " + endpoint + " can't be sent before the deadline", 0, "");
+      }
+      return std::nullopt;
+    }
 
-        throw Infisical::InfisicalError(errorMsg, response.status_code, response.text);
+    cpr::Response HttpClient::request(
+        Method method,
+        const std::string &endpoint,
+        const std::map<std::string, std::string> &headers,
+        const std::map<std::string, std::string> &params,
+        const std::string &body)
+    {
+      return tryRequest(method, endpoint, headers, params, body).value();
+    }
+
+    long HttpClient::requestStreaming(
+        Method method,
+        const std::string &endpoint,
+        const std::function<bool(std::string_view)> &onBody,
+        const std::map<std::string, std::string> &headers,
+        const std::map<std::string, std::string> &params,
+        const std::string &body)
+    {
+      return tryRequestStreaming(method, endpoint, onBody, headers, params, body).value();
+    }
+
+    Result<cpr::Response> HttpClient::tryRequest(
+        Method method,
+        const std::string &endpoint,
+        const std::map<std::string, std::string> &headers,
+        const std::map<std::string, std::string> &params,
+        const std::string &body)
+    {
+      // Prepare the URL
+      auto &url = requestScratch().url;
+      url.assign(m_baseUrl).append(endpoint);
+
+      if (auto error = admit(endpoint))
+      {
+        return std::move(*error);
       }
 
+      auto response = perform(method, url, headers, params, body, nullptr);
+      if (auto error = checkResponse(method, url, endpoint, response))
+      {
+        return std::move(*error);
+      }
       return response;
     }
 
+    Result<long> HttpClient::tryRequestStreaming(
+        Method method,
+        const std::string &endpoint,
+        const std::function<bool(std::string_view)> &onBody,
+        const std::map<std::string, std::string> &headers,
+        const std::map<std::string, std::string> &params,
+        const std::string &body)
+    {
+      auto &url = requestScratch().url;
+      url.assign(m_baseUrl).append(endpoint);
+
+      if (auto error = admit(endpoint))
+      {
+        return std::move(*error);
+      }
+
+      auto response = perform(method, url, headers, params, body, &onBody);
+      if (auto error = checkResponse(method, url, endpoint, response))
+      {
+        return std::move(*error);
+      }
+      return response.status_code;
+    }
+
     cpr::Response HttpClient::get(
         const std::string &endpoint,
         const std::map<std::string, std::string> &headers,
@@ -0,0 +1,148 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+
+namespace Infisical
+{
+
+  namespace http
+  {
+
+    void RateLimiter::setLimit(EndpointClass endpointClass, double requestsPerSecond, size_t burst)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto &bucket = m_buckets[static_cast<size_t>(endpointClass)];
+      bucket.rate = std::max(requestsPerSecond, 0.0);
+      bucket.capacity = static_cast<double>(std::max<size_t>(burst, 1));
+      bucket.tokens = bucket.capacity;
+      bucket.refilled = std::chrono::steady_clock::now();
+
+      // the new limit may let the front of the queue go right away
+      if (!bucket.waiters.empty())
+      {
+        bucket.waiters.front()->notify_one();
+      }
+    }
+
+    bool RateLimiter::acquire(EndpointClass endpointClass, std::optional<std::chrono::steady_clock::time_point> deadline)
+    {
+      auto &bucket = m_buckets[static_cast<size_t>(endpointClass)];
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      auto now = std::chrono::steady_clock::now();
+      refill(bucket, now);
+      if (bucket.rate <= 0 || (bucket.waiters.empty() && bucket.tokens >= 1))
+      {
+        if (bucket.rate > 0)
+        {
+          bucket.tokens -= 1;
+        }
+        return true;
+      }
+
+      // everyone already in line takes a token first
+      if (deadline && now + timeUntil(bucket, bucket.waiters.size() + 1) > *deadline)
+      {
+        return false;
+      }
+
+      std::condition_variable wakeup;
+      const auto self = bucket.waiters.insert(bucket.waiters.end(), &wakeup);
+      bool granted = false;
+      while (true)
+      {
+        now = std::chrono::steady_clock::now();
+        refill(bucket, now);
+
+        if (bucket.rate <= 0 || (bucket.waiters.front() == &wakeup && bucket.tokens >= 1))
+        {
+          if (bucket.rate > 0)
+          {
+            bucket.tokens -= 1;
+          }
+          granted = true;
+          break;
+        }
+
+        if (bucket.waiters.front() == &wakeup)
+        {
+          const auto ready = now + timeUntil(bucket, 1);
+          if (deadline && ready > *deadline)
+          {
+            break;
+          }
+          wakeup.wait_until(lock, ready);
+        }
+        else if (deadline)
+        {
+          if (now >= *deadline)
+          {
+            break;
+          }
+          wakeup.wait_until(lock, *deadline);
+        }
+        else
+        {
+          wakeup.wait(lock);
+        }
+      }
+
+      bucket.waiters.erase(self);
+      if (!bucket.waiters.empty())
+      {
+        bucket.waiters.front()->notify_one();
+      }
+      return granted;
+    }
+
+    EndpointClass RateLimiter::classify(std::string_view endpoint)
+    {
+      if (endpoint.compare(0, 13, "/api/v1/auth/") == 0)
+      {
+        return EndpointClass::AUTH;
+      }
+      // "/secrets/raw", "/secret/{id}/secret-versions", ...
+      if (endpoint.find("/secret") != std::string_view::npos)
+      {
+        return EndpointClass::SECRETS;
+      }
+      return EndpointClass::OTHER;
+    }
+
+    void RateLimiter::prepareFork()
+    {
+      m_mutex.lock();
+    }
+
+    void RateLimiter::afterForkInParent()
+    {
+      m_mutex.unlock();
+    }
+
+    void RateLimiter::afterForkInChild()
+    {
+      for (auto &bucket : m_buckets)
+      {
+        bucket.waiters.clear();
+      }
+      m_mutex.unlock();
+    }
+
+    void RateLimiter::refill(Bucket &bucket, std::chrono::steady_clock::time_point now)
+    {
+      const std::chrono::duration<double> elapsed = now - bucket.refilled;
+      bucket.tokens = std::min(bucket.capacity, bucket.tokens + elapsed.count() * bucket.rate);
+      bucket.refilled = now;
+    }
+
+    std::chrono::steady_clock::duration RateLimiter::timeUntil(const Bucket &bucket, size_t tokens)
+    {
+      const double missing = static_cast<double>(tokens) - bucket.tokens;
+      if (missing <= 0)
+      {
+        return std::chrono::steady_clock::duration::zero();
+      }
+      return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(missing / bucket.rate));
+    }
+
+  } // namespace http
+}
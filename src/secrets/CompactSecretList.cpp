@@ -0,0 +1,279 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+  constexpr uint32_t FLAG_SKIP_MULTILINE_ENCODING = 1u << 0;
+  constexpr uint32_t FLAG_IS_ROTATED_SECRET = 1u << 1;
+
+  struct SecretFields
+  {
+    std::string_view id;
+    std::string_view workspace;
+    std::string_view environment;
+    std::string_view type;
+    std::string_view secretKey;
+    std::string_view secretValue;
+    std::string_view secretPath;
+    std::string_view rotationId;
+    unsigned int version = 0;
+    bool skipMultilineEncoding = false;
+    bool isRotatedSecret = false;
+  };
+
+  std::string_view stringField(const nlohmann::json &j, const char *name)
+  {
+    return j.at(name).get_ref<const std::string &>();
+  }
+
+  // mirrors from_json(TSecret), but reads the strings in place instead of copying them
+  SecretFields fieldsFromJson(const nlohmann::json &j)
+  {
+    SecretFields fields;
+    fields.id = stringField(j, "id");
+    fields.workspace = stringField(j, "workspace");
+    fields.environment = stringField(j, "environment");
+    fields.type = stringField(j, "type");
+    fields.secretKey = stringField(j, "secretKey");
+    fields.secretValue = stringField(j, "secretValue");
+    j.at("version").get_to(fields.version);
+    j.at("skipMultilineEncoding").get_to(fields.skipMultilineEncoding);
+
+    if (j.contains("secretPath"))
+    {
+      fields.secretPath = stringField(j, "secretPath");
+    }
+    if (j.contains("rotationId") && !j.at("rotationId").is_null())
+    {
+      fields.rotationId = stringField(j, "rotationId");
+    }
+    if (j.contains("isRotatedSecret"))
+    {
+      j.at("isRotatedSecret").get_to(fields.isRotatedSecret);
+    }
+    return fields;
+  }
+
+  SecretFields fieldsFromSecret(const Infisical::Secrets::TSecret &secret)
+  {
+    SecretFields fields;
+    fields.id = secret.getId();
+    fields.workspace = secret.getWorkspace();
+    fields.environment = secret.getEnvironment();
+    fields.type = secret.getType();
+    fields.secretKey = secret.getSecretKey();
+    fields.secretValue = secret.getSecretValue();
+    fields.secretPath = secret.getSecretPath();
+    fields.rotationId = secret.getRotationId();
+    fields.version = secret.getVersion();
+    fields.skipMultilineEncoding = secret.getSkipMultilineEncoding();
+    fields.isRotatedSecret = secret.getIsRotatedSecret();
+    return fields;
+  }
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    /*
+     * Fills a CompactSecretList. The string_views passed to add() must stay valid until the builder is finished, which is always the case as they point into the JSON document or TSecret vector being converted.
+     */
+    class CompactSecretList::Builder
+    {
+    public:
+      enum class OnDuplicate
+      {
+        KEEP_ALL,
+        KEEP_FIRST,
+        KEEP_LAST
+      };
+
+      explicit Builder(CompactSecretList &list) : _list(list) {}
+
+      void reserve(size_t count)
+      {
+        _list._records.reserve(count);
+        _byKey.reserve(count);
+      }
+
+      void add(const SecretFields &fields, OnDuplicate onDuplicate)
+      {
+        auto existing = _byKey.find(fields.secretKey);
+        if (existing != _byKey.end())
+        {
+          if (onDuplicate == OnDuplicate::KEEP_FIRST)
+          {
+            return;
+          }
+          if (onDuplicate == OnDuplicate::KEEP_LAST)
+          {
+            // the old bytes stay in the arena, duplicates are rare enough that it's not worth compacting
+            _list._records[existing->second] = makeRecord(fields);
+            return;
+          }
+        }
+
+        _byKey.emplace(fields.secretKey, static_cast<uint32_t>(_list._records.size()));
+        _list._records.push_back(makeRecord(fields));
+      }
+
+      void finish()
+      {
+        auto &list = _list;
+        list._arena.shrink_to_fit();
+        list._sortedIndex.resize(list._records.size());
+        for (uint32_t i = 0; i < list._sortedIndex.size(); i++)
+        {
+          list._sortedIndex[i] = i;
+        }
+        std::sort(list._sortedIndex.begin(), list._sortedIndex.end(), [&list](uint32_t a, uint32_t b)
+                  { return list.span(list._records[a].secretKey) < list.span(list._records[b].secretKey); });
+      }
+
+    private:
+      Span append(std::string_view value)
+      {
+        if (_list._arena.size() + value.size() > UINT32_MAX)
+        {
+          throw InfisicalError("CompactSecretList: secrets exceed the maximum supported size", 0, "");
+        }
+        Span s{static_cast<uint32_t>(_list._arena.size()), static_cast<uint32_t>(value.size())};
+        _list._arena.append(value.data(), value.size());
+        return s;
+      }
+
+      uint32_t intern(std::string_view value)
+      {
+        auto it = _interned.find(value);
+        if (it != _interned.end())
+        {
+          return it->second;
+        }
+        auto index = static_cast<uint32_t>(_list._interned.size());
+        _list._interned.emplace_back(value);
+        _interned.emplace(value, index);
+        return index;
+      }
+
+      Record makeRecord(const SecretFields &fields)
+      {
+        Record record;
+        record.id = append(fields.id);
+        record.secretKey = append(fields.secretKey);
+        record.secretValue = append(fields.secretValue);
+        record.rotationId = append(fields.rotationId);
+        record.workspace = intern(fields.workspace);
+        record.environment = intern(fields.environment);
+        record.type = intern(fields.type);
+        record.secretPath = intern(fields.secretPath);
+        record.version = fields.version;
+        record.flags = (fields.skipMultilineEncoding ? FLAG_SKIP_MULTILINE_ENCODING : 0) |
+                       (fields.isRotatedSecret ? FLAG_IS_ROTATED_SECRET : 0);
+        return record;
+      }
+
+      CompactSecretList &_list;
+      std::unordered_map<std::string_view, uint32_t> _byKey;
+      std::unordered_map<std::string_view, uint32_t> _interned;
+    };
+
+    CompactSecretList CompactSecretList::fromSecrets(const std::vector<TSecret> &secrets)
+    {
+      CompactSecretList list;
+      Builder builder(list);
+      builder.reserve(secrets.size());
+      for (const auto &secret : secrets)
+      {
+        builder.add(fieldsFromSecret(secret), Builder::OnDuplicate::KEEP_ALL);
+      }
+      builder.finish();
+      list._interned.shrink_to_fit();
+      return list;
+    }
+
+    CompactSecretList CompactSecretList::fromListResponse(const nlohmann::json &response, bool uniqueByKey)
+    {
+      const auto &secrets = response.at("secrets");
+      const auto *imports = response.contains("imports") && response.at("imports").is_array() ? &response.at("imports") : nullptr;
+
+      size_t total = secrets.size();
+      if (imports != nullptr)
+      {
+        for (const auto &import : *imports)
+        {
+          total += import.at("secrets").size();
+        }
+      }
+
+      CompactSecretList list;
+      Builder builder(list);
+      builder.reserve(total);
+
+      // same precedence as listSecrets(): with recursive listings the last secret of a key wins, and imported secrets never override secrets of the listed path
+      for (const auto &secret : secrets)
+      {
+        builder.add(fieldsFromJson(secret), uniqueByKey ? Builder::OnDuplicate::KEEP_LAST : Builder::OnDuplicate::KEEP_ALL);
+      }
+
+      if (imports != nullptr)
+      {
+        for (const auto &import : *imports)
+        {
+          std::string_view importPath = stringField(import, "secretPath");
+          for (const auto &secret : import.at("secrets"))
+          {
+            auto fields = fieldsFromJson(secret);
+            fields.secretPath = importPath;
+            builder.add(fields, Builder::OnDuplicate::KEEP_FIRST);
+          }
+        }
+      }
+
+      builder.finish();
+      list._interned.shrink_to_fit();
+      return list;
+    }
+
+    std::optional<CompactSecret> CompactSecretList::find(std::string_view secretKey) const
+    {
+      auto it = std::lower_bound(_sortedIndex.begin(), _sortedIndex.end(), secretKey, [this](uint32_t index, std::string_view key)
+                                 { return span(_records[index].secretKey) < key; });
+
+      if (it == _sortedIndex.end() || span(_records[*it].secretKey) != secretKey)
+      {
+        return std::nullopt;
+      }
+      return CompactSecret(this, *it);
+    }
+
+    size_t CompactSecretList::getMemoryUsage() const
+    {
+      size_t total = _arena.capacity() +
+                     _records.capacity() * sizeof(Record) +
+                     _sortedIndex.capacity() * sizeof(uint32_t) +
+                     _interned.capacity() * sizeof(std::string);
+      for (const auto &str : _interned)
+      {
+        total += str.size();
+      }
+      return total;
+    }
+
+    std::string_view CompactSecret::getId() const { return list->span(list->_records[index].id); }
+    std::string_view CompactSecret::getWorkspace() const { return list->_interned[list->_records[index].workspace]; }
+    std::string_view CompactSecret::getEnvironment() const { return list->_interned[list->_records[index].environment]; }
+    unsigned int CompactSecret::getVersion() const { return list->_records[index].version; }
+    std::string_view CompactSecret::getType() const { return list->_interned[list->_records[index].type]; }
+    std::string_view CompactSecret::getSecretKey() const { return list->span(list->_records[index].secretKey); }
+    std::string_view CompactSecret::getSecretValue() const { return list->span(list->_records[index].secretValue); }
+    std::string_view CompactSecret::getSecretPath() const { return list->_interned[list->_records[index].secretPath]; }
+    std::string_view CompactSecret::getRotationId() const { return list->span(list->_records[index].rotationId); }
+    bool CompactSecret::getSkipMultilineEncoding() const { return (list->_records[index].flags & FLAG_SKIP_MULTILINE_ENCODING) != 0; }
+    bool CompactSecret::getIsRotatedSecret() const { return (list->_records[index].flags & FLAG_IS_ROTATED_SECRET) != 0; }
+  }
+}
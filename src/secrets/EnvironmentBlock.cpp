@@ -0,0 +1,142 @@
+#include <libinfisical/InfisicalClient.h>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <stdlib.h>
+#define environ _environ
+#else
+#include <unistd.h>
+extern char **environ;
+#endif
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    /*
+     * Collects KEY=VALUE pairs as views into the inherited environment and the secrets, then copies them into the block in a single allocation.
+     */
+    class EnvironmentBlock::Builder
+    {
+    public:
+      Builder(Input::EnvironmentVariableOverwritePolicy policy, bool inheritCurrentEnvironment)
+          : _policy(policy)
+      {
+        if (!inheritCurrentEnvironment || environ == nullptr)
+        {
+          return;
+        }
+
+        for (char **env = environ; *env != nullptr; env++)
+        {
+          std::string_view entry(*env);
+          auto separator = entry.find('=');
+          if (separator == std::string_view::npos || separator == 0)
+          {
+            continue;
+          }
+          addEntry(entry.substr(0, separator), entry.substr(separator + 1), true);
+        }
+      }
+
+      void add(std::string_view key, std::string_view value)
+      {
+        // keys that can't be represented in an environment block are skipped, same as setenv() refusing them
+        if (key.empty() || key.find('=') != std::string_view::npos || key.find('\0') != std::string_view::npos)
+        {
+          return;
+        }
+        addEntry(key, value, false);
+      }
+
+      EnvironmentBlock finish()
+      {
+        size_t total = 0;
+        for (const auto &entry : _entries)
+        {
+          total += entry.key.size() + 1 + entry.value.size() + 1;
+        }
+
+        EnvironmentBlock block;
+        block._buffer.resize(total);
+        block._pointers.reserve(_entries.size() + 1);
+
+        char *out = block._buffer.data();
+        for (const auto &entry : _entries)
+        {
+          block._pointers.push_back(out);
+          std::memcpy(out, entry.key.data(), entry.key.size());
+          out += entry.key.size();
+          *out++ = '=';
+          std::memcpy(out, entry.value.data(), entry.value.size());
+          out += entry.value.size();
+          *out++ = '\0';
+        }
+        block._pointers.push_back(nullptr);
+
+        return block;
+      }
+
+    private:
+      struct Entry
+      {
+        std::string_view key;
+        std::string_view value;
+        bool inherited;
+      };
+
+      void addEntry(std::string_view key, std::string_view value, bool inherited)
+      {
+        auto existing = _byKey.find(key);
+        if (existing == _byKey.end())
+        {
+          _byKey.emplace(key, _entries.size());
+          _entries.push_back({key, value, inherited});
+          return;
+        }
+
+        auto &entry = _entries[existing->second];
+        // a later secret of the same key wins, like ensureUniqueSecretsByKey(); the policy only decides about inherited variables.
+        // The setenv() path differs under SKIP_EXISTING: there the first secret's setenv() makes the variable exist and the later ones are skipped
+        if (!inherited && (!entry.inherited || _policy == Input::EnvironmentVariableOverwritePolicy::OVERWRITE))
+        {
+          entry.value = value;
+          entry.inherited = false;
+        }
+      }
+
+      Input::EnvironmentVariableOverwritePolicy _policy;
+      std::vector<Entry> _entries;
+      std::unordered_map<std::string_view, size_t> _byKey;
+    };
+
+    EnvironmentBlock EnvironmentBlock::fromSecrets(
+        const std::vector<TSecret> &secrets,
+        Input::EnvironmentVariableOverwritePolicy policy,
+        bool inheritCurrentEnvironment)
+    {
+      Builder builder(policy, inheritCurrentEnvironment);
+      for (const auto &secret : secrets)
+      {
+        builder.add(secret.getSecretKey(), std::string_view(secret.getSecretValue().data(), secret.getSecretValue().size()));
+      }
+      return builder.finish();
+    }
+
+    EnvironmentBlock EnvironmentBlock::fromSecrets(
+        const CompactSecretList &secrets,
+        Input::EnvironmentVariableOverwritePolicy policy,
+        bool inheritCurrentEnvironment)
+    {
+      Builder builder(policy, inheritCurrentEnvironment);
+      for (size_t i = 0; i < secrets.size(); i++)
+      {
+        builder.add(secrets[i].getSecretKey(), secrets[i].getSecretValue());
+      }
+      return builder.finish();
+    }
+  }
+}
@@ -0,0 +1,174 @@
+#include <libinfisical/InfisicalClient.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+  // at or above this many unloaded values, one listing request is cheaper than a request per secret
+  constexpr size_t LAZY_BATCH_THRESHOLD = 4;
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    struct LazySecretState
+    {
+      SecretsClient *client;
+      Input::ListSecretsOptions options;
+      std::vector<TSecret> secrets;
+      // filled once and never changed afterwards, so references handed out stay valid without holding the lock
+      std::vector<std::optional<SecretString>> values;
+      std::unordered_map<std::string_view, size_t> byKey;
+      std::mutex mutex;
+
+      LazySecretState(SecretsClient *client, Input::ListSecretsOptions options, std::vector<TSecret> secrets)
+          : client(client), options(std::move(options)), secrets(std::move(secrets)), values(this->secrets.size())
+      {
+        byKey.reserve(this->secrets.size());
+        for (size_t i = 0; i < this->secrets.size(); i++)
+        {
+          byKey.emplace(this->secrets[i].getSecretKey(), i);
+        }
+      }
+
+      ~LazySecretState()
+      {
+        for (auto &value : values)
+        {
+          if (value)
+          {
+            secure::wipe(*value);
+          }
+        }
+      }
+
+      // callers must hold the mutex
+      void fetchOne(size_t index)
+      {
+        const auto &secret = secrets[index];
+        auto getSecretOptions = Input::GetSecretOptionsBuilder()
+                                    .withProjectId(options.getProjectId())
+                                    .withEnvironment(secret.getEnvironment())
+                                    .withSecretPath(secret.getSecretPath().empty() ? options.getSecretPath() : secret.getSecretPath())
+                                    .withSecretKey(secret.getSecretKey())
+                                    .withType(secret.getType())
+                                    .withExpandSecretReferences(options.getExpandSecretReferences())
+                                    .build();
+
+        auto fetched = client->getSecret(getSecretOptions);
+        values[index].emplace(fetched.getSecretValue());
+      }
+
+      // callers must hold the mutex
+      void fetchBatch()
+      {
+        auto fetched = client->fetchSecrets(options, true);
+        for (const auto &secret : fetched)
+        {
+          auto it = byKey.find(secret.getSecretKey());
+          if (it != byKey.end() && !values[it->second])
+          {
+            values[it->second].emplace(secret.getSecretValue());
+          }
+        }
+      }
+
+      void load(const std::vector<size_t> &indices)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::vector<size_t> missing;
+        for (auto index : indices)
+        {
+          if (!values[index])
+          {
+            missing.push_back(index);
+          }
+        }
+
+        if (missing.size() >= LAZY_BATCH_THRESHOLD)
+        {
+          fetchBatch();
+        }
+
+        // anything the batch didn't cover (e.g. a secret deleted since listing) is fetched on its own, which reports the error for that key
+        for (auto index : missing)
+        {
+          if (!values[index])
+          {
+            fetchOne(index);
+          }
+        }
+      }
+    };
+
+    LazySecretList LazySecretList::fromListing(SecretsClient *client, Input::ListSecretsOptions options, std::vector<TSecret> secrets)
+    {
+      return LazySecretList(std::make_shared<LazySecretState>(client, std::move(options), std::move(secrets)));
+    }
+
+    size_t LazySecretList::size() const
+    {
+      return state->secrets.size();
+    }
+
+    std::optional<LazySecret> LazySecretList::find(const std::string &secretKey) const
+    {
+      auto it = state->byKey.find(secretKey);
+      if (it == state->byKey.end())
+      {
+        return std::nullopt;
+      }
+      return LazySecret(state, it->second);
+    }
+
+    void LazySecretList::prefetch(const std::vector<std::string> &secretKeys) const
+    {
+      std::vector<size_t> indices;
+      indices.reserve(secretKeys.size());
+      for (const auto &key : secretKeys)
+      {
+        auto it = state->byKey.find(key);
+        if (it != state->byKey.end())
+        {
+          indices.push_back(it->second);
+        }
+      }
+      state->load(indices);
+    }
+
+    void LazySecretList::prefetchAll() const
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->fetchBatch();
+    }
+
+    const std::string &LazySecret::getId() const { return state->secrets[index].getId(); }
+    const std::string &LazySecret::getWorkspace() const { return state->secrets[index].getWorkspace(); }
+    const std::string &LazySecret::getEnvironment() const { return state->secrets[index].getEnvironment(); }
+    unsigned int LazySecret::getVersion() const { return state->secrets[index].getVersion(); }
+    const std::string &LazySecret::getType() const { return state->secrets[index].getType(); }
+    const std::string &LazySecret::getSecretKey() const { return state->secrets[index].getSecretKey(); }
+    const std::string &LazySecret::getSecretPath() const { return state->secrets[index].getSecretPath(); }
+    const std::vector<SecretMetadata> &LazySecret::getSecretMetadata() const { return state->secrets[index].getSecretMetadata(); }
+
+    bool LazySecret::isValueLoaded() const
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      return state->values[index].has_value();
+    }
+
+    const SecretString &LazySecret::getSecretValue() const
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (!state->values[index])
+      {
+        state->fetchOne(index);
+      }
+      return *state->values[index];
+    }
+  }
+}
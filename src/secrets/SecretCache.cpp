@@ -0,0 +1,309 @@
+#include <libinfisical/InfisicalClient.h>
+#include <cctype>
+#include <charconv>
+#include <limits>
+
+namespace
+{
+  constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+  std::string_view trim(std::string_view value)
+  {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front())))
+    {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())))
+    {
+      value.remove_suffix(1);
+    }
+    return value;
+  }
+
+  bool equalsIgnoreCase(std::string_view a, std::string_view b)
+  {
+    if (a.size() != b.size())
+    {
+      return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+      if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::optional<int64_t> parseInteger(std::string_view value)
+  {
+    value = trim(value);
+    if (!value.empty() && value.front() == '+')
+    {
+      value.remove_prefix(1);
+    }
+
+    int64_t result;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (value.empty() || error != std::errc() || end != value.data() + value.size())
+    {
+      return std::nullopt;
+    }
+    return result;
+  }
+
+  std::optional<bool> parseBoolean(std::string_view value)
+  {
+    value = trim(value);
+    for (auto truthy : {"true", "1", "yes", "on"})
+    {
+      if (equalsIgnoreCase(value, truthy))
+      {
+        return true;
+      }
+    }
+    for (auto falsy : {"false", "0", "no", "off"})
+    {
+      if (equalsIgnoreCase(value, falsy))
+      {
+        return false;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // "30s", "500ms", "1h30m", "2d". A plain number has no unit of its own, SecretCache::get() counts it in the unit of the requested type.
+  // Anything that doesn't fit in int64_t milliseconds is rejected, the values come from secrets and can't be trusted to be sane
+  std::optional<std::chrono::milliseconds> parseDuration(std::string_view value)
+  {
+    value = trim(value);
+    if (value.empty())
+    {
+      return std::nullopt;
+    }
+
+    constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+    int64_t total = 0;
+    while (!value.empty())
+    {
+      int64_t amount;
+      auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), amount);
+      if (error != std::errc() || end == value.data() || amount < 0)
+      {
+        return std::nullopt;
+      }
+      value.remove_prefix(static_cast<size_t>(end - value.data()));
+
+      size_t unitLength = 0;
+      while (unitLength < value.size() && std::isalpha(static_cast<unsigned char>(value[unitLength])))
+      {
+        unitLength++;
+      }
+      const auto unit = value.substr(0, unitLength);
+      value.remove_prefix(unitLength);
+
+      int64_t millisecondsPerUnit;
+      if (unit == "ms")
+      {
+        millisecondsPerUnit = 1;
+      }
+      else if (unit == "s")
+      {
+        millisecondsPerUnit = 1000;
+      }
+      else if (unit == "m")
+      {
+        millisecondsPerUnit = 60 * 1000;
+      }
+      else if (unit == "h")
+      {
+        millisecondsPerUnit = 60 * 60 * 1000;
+      }
+      else if (unit == "d")
+      {
+        millisecondsPerUnit = 24 * 60 * 60 * 1000;
+      }
+      else
+      {
+        return std::nullopt;
+      }
+
+      if (amount > MAX / millisecondsPerUnit || amount * millisecondsPerUnit > MAX - total)
+      {
+        return std::nullopt;
+      }
+      total += amount * millisecondsPerUnit;
+    }
+    return std::chrono::milliseconds(total);
+  }
+
+  // only objects and arrays, a secret that happens to be a number or `true` is read through the other forms
+  std::optional<nlohmann::json> parseJson(std::string_view value)
+  {
+    value = trim(value);
+    if (value.empty() || (value.front() != '{' && value.front() != '['))
+    {
+      return std::nullopt;
+    }
+
+    auto parsed = nlohmann::json::parse(value.begin(), value.end(), nullptr, false);
+    if (parsed.is_discarded())
+    {
+      return std::nullopt;
+    }
+    return parsed;
+  }
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    SecretCache::SecretCache(SecretsClient &client, Input::ListSecretsOptions options)
+        : _client(&client), _options(std::move(options))
+    {
+    }
+
+    void SecretCache::refresh()
+    {
+      assign(_client->listSecrets(_options));
+    }
+
+    void SecretCache::assign(const std::vector<TSecret> &secrets)
+    {
+      std::vector<Entry> entries;
+      entries.reserve(secrets.size());
+
+      // at most half full, so probe sequences stay short
+      size_t capacity = 8;
+      while (capacity < secrets.size() * 2)
+      {
+        capacity *= 2;
+      }
+      std::vector<Slot> slots(capacity, Slot{0, EMPTY_SLOT});
+      const auto mask = capacity - 1;
+
+      for (const auto &secret : secrets)
+      {
+        const auto &key = secret.getSecretKey();
+        const auto hash = secretKeyHash(key);
+
+        auto slot = hash & mask;
+        while (slots[slot].index != EMPTY_SLOT &&
+               !(slots[slot].hash == hash && entries[slots[slot].index].key == key))
+        {
+          slot = (slot + 1) & mask;
+        }
+
+        const auto &value = secret.getSecretValue();
+        const std::string_view raw(value.data(), value.size());
+
+        Entry entry;
+        entry.key = key;
+        entry.value = value;
+        entry.integer = parseInteger(raw);
+        entry.boolean = parseBoolean(raw);
+        entry.duration = parseDuration(raw);
+        entry.json = parseJson(raw);
+
+        // the last secret of a key wins, same as ensureUniqueSecretsByKey()
+        if (slots[slot].index != EMPTY_SLOT)
+        {
+          entries[slots[slot].index] = std::move(entry);
+          continue;
+        }
+
+        slots[slot] = Slot{hash, static_cast<uint32_t>(entries.size())};
+        entries.push_back(std::move(entry));
+      }
+
+      _entries.swap(entries);
+      _slots.swap(slots);
+
+      // checked against the new contents in place, and swapped back if they don't hold
+      auto unmet = unmetExpectations();
+      if (!unmet.empty())
+      {
+        _entries.swap(entries);
+        _slots.swap(slots);
+        throw InfisicalError("Secrets don't match the expected types, keeping the previous ones: " + unmet, 0, "");
+      }
+    }
+
+    std::string SecretCache::unmetExpectations() const
+    {
+      std::string unmet;
+      for (const auto &expectation : _expectations)
+      {
+        const auto *entry = lookup(expectation.name, expectation.hash);
+        const char *problem = nullptr;
+        if (entry == nullptr)
+        {
+          problem = "missing";
+        }
+        else if (expectation.kind == ValueKind::INTEGER && !inRange(*entry, expectation.min, expectation.max))
+        {
+          problem = "not an integer in range";
+        }
+        else if (expectation.kind == ValueKind::BOOLEAN && !entry->boolean)
+        {
+          problem = "not a boolean";
+        }
+        else if (expectation.kind == ValueKind::DURATION && !expectation.accepts(*entry))
+        {
+          problem = "not a duration exactly representable in the requested type";
+        }
+        else if (expectation.kind == ValueKind::JSON && !entry->json)
+        {
+          problem = "not a JSON object or array";
+        }
+
+        if (problem != nullptr)
+        {
+          unmet.append(unmet.empty() ? "" : ", ").append(expectation.name).append(" is ").append(problem);
+        }
+      }
+      return unmet;
+    }
+
+    const SecretCache::Entry *SecretCache::lookup(std::string_view name, uint64_t hash) const
+    {
+      if (_slots.empty())
+      {
+        return nullptr;
+      }
+
+      const auto mask = _slots.size() - 1;
+      for (auto slot = hash & mask;; slot = (slot + 1) & mask)
+      {
+        const auto &candidate = _slots[slot];
+        if (candidate.index == EMPTY_SLOT)
+        {
+          return nullptr;
+        }
+        if (candidate.hash == hash && _entries[candidate.index].key == name)
+        {
+          return &_entries[candidate.index];
+        }
+      }
+    }
+
+    const SecretCache::Entry &SecretCache::require(std::string_view name, uint64_t hash) const
+    {
+      const auto *entry = lookup(name, hash);
+      if (entry == nullptr)
+      {
+        throw InfisicalError("Secret not found in cache: " + std::string(name), 0, "");
+      }
+      return *entry;
+    }
+
+    void SecretCache::throwConversionError(std::string_view name, const char *expected)
+    {
+      throw InfisicalError("Secret " + std::string(name) + " is not " + expected, 0, "");
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#include <libinfisical/InfisicalClient.h>
+#include <unordered_map>
+
+namespace
+{
+  bool isSameSecret(const Infisical::Secrets::TSecret &a, const Infisical::Secrets::TSecret &b)
+  {
+    return a.getType() == b.getType() && a.getSecretPath() == b.getSecretPath();
+  }
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    SecretChangeSet diffSecrets(const std::vector<TSecret> &previous, const std::vector<TSecret> &current)
+    {
+      SecretChangeSet changes;
+
+      // keyed by secret key only, so building the index doesn't allocate a composite key per secret. The rare key collisions (personal overrides, same key in another folder) are told apart by isSameSecret()
+      std::unordered_multimap<std::string_view, size_t> previousByKey;
+      previousByKey.reserve(previous.size());
+      for (size_t i = 0; i < previous.size(); i++)
+      {
+        previousByKey.emplace(previous[i].getSecretKey(), i);
+      }
+
+      std::vector<bool> matched(previous.size(), false);
+
+      for (const auto &secret : current)
+      {
+        const TSecret *old = nullptr;
+        auto range = previousByKey.equal_range(secret.getSecretKey());
+        for (auto it = range.first; it != range.second; ++it)
+        {
+          if (!matched[it->second] && isSameSecret(previous[it->second], secret))
+          {
+            matched[it->second] = true;
+            old = &previous[it->second];
+            break;
+          }
+        }
+
+        if (old == nullptr)
+        {
+          changes.added.push_back(secret);
+        }
+        else if (old->getVersion() != secret.getVersion() || old->getSecretValue() != secret.getSecretValue())
+        {
+          changes.modified.push_back(secret);
+        }
+      }
+
+      for (size_t i = 0; i < previous.size(); i++)
+      {
+        if (!matched[i])
+        {
+          changes.removed.push_back(previous[i]);
+        }
+      }
+
+      return changes;
+    }
+  }
+}
@@ -0,0 +1,346 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+  // expansion recurses once per reference in a chain, the secrets come from the server and shouldn't be able to exhaust the stack
+  constexpr size_t MAX_REFERENCE_DEPTH = 64;
+
+  struct ParsedReference
+  {
+    size_t begin; // offset of "${"
+    size_t end;   // offset one past "}"
+    Infisical::Secrets::SecretLocation location;
+  };
+
+  std::string normalizeSecretPath(const std::string &path)
+  {
+    if (path.empty())
+    {
+      return "/";
+    }
+
+    std::string normalized = path.front() == '/' ? path : "/" + path;
+    while (normalized.size() > 1 && normalized.back() == '/')
+    {
+      normalized.pop_back();
+    }
+    return normalized;
+  }
+
+  std::string nodeIdOf(const Infisical::Secrets::SecretLocation &location)
+  {
+    // \x1f (unit separator) can't appear in environment slugs, paths or keys
+    std::string id;
+    id.reserve(location.environment.size() + location.secretPath.size() + location.secretKey.size() + 2);
+    id.append(location.environment).append(1, '\x1f').append(location.secretPath).append(1, '\x1f').append(location.secretKey);
+    return id;
+  }
+
+  std::string describe(const Infisical::Secrets::SecretLocation &location)
+  {
+    return location.environment + ":" + location.secretPath + (location.secretPath == "/" ? "" : "/") + location.secretKey;
+  }
+
+  // ${KEY} refers to the same environment and folder, ${env.a.b.KEY} to KEY in folder /a/b of env
+  std::vector<ParsedReference> parseReferences(std::string_view value, const Infisical::Secrets::SecretLocation &self)
+  {
+    std::vector<ParsedReference> references;
+
+    size_t pos = 0;
+    while ((pos = value.find("${", pos)) != std::string_view::npos)
+    {
+      auto close = value.find('}', pos + 2);
+      if (close == std::string_view::npos)
+      {
+        break;
+      }
+
+      auto inner = value.substr(pos + 2, close - pos - 2);
+
+      std::vector<std::string_view> parts;
+      size_t start = 0;
+      while (true)
+      {
+        auto dot = inner.find('.', start);
+        parts.push_back(inner.substr(start, dot == std::string_view::npos ? std::string_view::npos : dot - start));
+        if (dot == std::string_view::npos)
+        {
+          break;
+        }
+        start = dot + 1;
+      }
+
+      bool valid = std::none_of(parts.begin(), parts.end(), [](std::string_view part)
+                                { return part.empty(); });
+      if (valid)
+      {
+        ParsedReference reference{pos, close + 1, {}};
+        if (parts.size() == 1)
+        {
+          reference.location = {self.environment, self.secretPath, std::string(parts[0])};
+        }
+        else
+        {
+          std::string path;
+          for (size_t i = 1; i + 1 < parts.size(); i++)
+          {
+            path.append("/").append(parts[i]);
+          }
+          reference.location = {std::string(parts[0]), path.empty() ? "/" : path, std::string(parts.back())};
+        }
+        references.push_back(std::move(reference));
+      }
+
+      pos = close + 1;
+    }
+
+    return references;
+  }
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    SecretReferenceExpander::Node &SecretReferenceExpander::node(const std::string &id, const SecretLocation &location)
+    {
+      auto it = _nodes.find(id);
+      if (it == _nodes.end())
+      {
+        it = _nodes.emplace(id, Node{}).first;
+        it->second.location = location;
+      }
+      return it->second;
+    }
+
+    void SecretReferenceExpander::unlinkDependencies(const std::string &id, Node &n)
+    {
+      for (const auto &dependencyId : n.dependencies)
+      {
+        auto dependency = _nodes.find(dependencyId);
+        if (dependency == _nodes.end())
+        {
+          continue;
+        }
+
+        auto &dependents = dependency->second.dependents;
+        dependents.erase(std::remove(dependents.begin(), dependents.end(), id), dependents.end());
+
+        // placeholder nodes only exist to track who is waiting for them
+        if (!dependency->second.present && dependents.empty())
+        {
+          _nodes.erase(dependency);
+        }
+      }
+      n.dependencies.clear();
+    }
+
+    void SecretReferenceExpander::invalidate(const std::string &id, std::vector<SecretLocation> &changed)
+    {
+      std::unordered_set<std::string> visited{id};
+      std::vector<std::string> pending{id};
+
+      while (!pending.empty())
+      {
+        auto current = std::move(pending.back());
+        pending.pop_back();
+
+        auto it = _nodes.find(current);
+        if (it == _nodes.end())
+        {
+          continue;
+        }
+
+        auto &n = it->second;
+        if (n.expanded)
+        {
+          secure::wipe(*n.expanded);
+          n.expanded.reset();
+        }
+        changed.push_back(n.location);
+
+        for (const auto &dependent : n.dependents)
+        {
+          if (visited.insert(dependent).second)
+          {
+            pending.push_back(dependent);
+          }
+        }
+      }
+    }
+
+    std::vector<SecretLocation> SecretReferenceExpander::setSecret(
+        const std::string &environment,
+        const std::string &secretPath,
+        const std::string &secretKey,
+        std::string_view rawValue)
+    {
+      SecretLocation location{environment, normalizeSecretPath(secretPath), secretKey};
+      const auto id = nodeIdOf(location);
+
+      auto &n = node(id, location);
+      std::vector<SecretLocation> changed;
+
+      if (n.present && std::string_view(n.rawValue.data(), n.rawValue.size()) == rawValue)
+      {
+        return changed;
+      }
+
+      unlinkDependencies(id, n);
+      secure::wipe(n.rawValue);
+      n.rawValue.assign(rawValue.data(), rawValue.size());
+      n.present = true;
+
+      for (auto &reference : parseReferences(rawValue, location))
+      {
+        auto dependencyId = nodeIdOf(reference.location);
+        if (std::find(n.dependencies.begin(), n.dependencies.end(), dependencyId) != n.dependencies.end())
+        {
+          continue;
+        }
+
+        auto &dependency = node(dependencyId, reference.location);
+        dependency.dependents.push_back(id);
+        n.dependencies.push_back(std::move(dependencyId));
+      }
+
+      invalidate(id, changed);
+      return changed;
+    }
+
+    std::vector<SecretLocation> SecretReferenceExpander::removeSecret(
+        const std::string &environment,
+        const std::string &secretPath,
+        const std::string &secretKey)
+    {
+      SecretLocation location{environment, normalizeSecretPath(secretPath), secretKey};
+      const auto id = nodeIdOf(location);
+
+      std::vector<SecretLocation> changed;
+      auto it = _nodes.find(id);
+      if (it == _nodes.end() || !it->second.present)
+      {
+        return changed;
+      }
+
+      auto &n = it->second;
+      unlinkDependencies(id, n);
+      secure::wipe(n.rawValue);
+      n.present = false;
+
+      invalidate(id, changed);
+
+      if (n.dependents.empty())
+      {
+        _nodes.erase(id);
+      }
+      return changed;
+    }
+
+    std::vector<SecretLocation> SecretReferenceExpander::addSecrets(const std::vector<TSecret> &secrets, const std::string &defaultSecretPath)
+    {
+      std::vector<SecretLocation> changed;
+      for (const auto &secret : secrets)
+      {
+        const auto &value = secret.getSecretValue();
+        auto secretChanged = setSecret(
+            secret.getEnvironment(),
+            secret.getSecretPath().empty() ? defaultSecretPath : secret.getSecretPath(),
+            secret.getSecretKey(),
+            std::string_view(value.data(), value.size()));
+        changed.insert(changed.end(), std::make_move_iterator(secretChanged.begin()), std::make_move_iterator(secretChanged.end()));
+      }
+      return changed;
+    }
+
+    const SecretString &SecretReferenceExpander::expandNode(const std::string &id, std::vector<std::string> &stack)
+    {
+      auto it = _nodes.find(id);
+      if (it == _nodes.end() || !it->second.present)
+      {
+        std::string msg = "Secret reference not found: ";
+        msg += it == _nodes.end() ? id : describe(it->second.location);
+        if (!stack.empty())
+        {
+          msg += " (referenced by " + describe(_nodes.at(stack.back()).location) + ")";
+        }
+        throw InfisicalError(msg, 0, "");
+      }
+
+      auto &n = it->second;
+      if (n.expanded)
+      {
+        return *n.expanded;
+      }
+
+      auto onStack = std::find(stack.begin(), stack.end(), id);
+      if (onStack != stack.end())
+      {
+        std::string cycle;
+        for (auto entry = onStack; entry != stack.end(); entry++)
+        {
+          cycle += describe(_nodes.at(*entry).location) + " -> ";
+        }
+        cycle += describe(n.location);
+        throw InfisicalError("Secret reference cycle detected: " + cycle, 0, "");
+      }
+
+      if (stack.size() >= MAX_REFERENCE_DEPTH)
+      {
+        throw InfisicalError("Secret references nest deeper than " + std::to_string(MAX_REFERENCE_DEPTH) + " levels: " + describe(_nodes.at(stack.front()).location) +
+                                 " -> ... -> " + describe(n.location),
+                             0, "");
+      }
+
+      stack.push_back(id);
+
+      std::string_view raw(n.rawValue.data(), n.rawValue.size());
+      SecretString result;
+      result.reserve(raw.size());
+
+      size_t copied = 0;
+      for (const auto &reference : parseReferences(raw, n.location))
+      {
+        result.append(raw.data() + copied, reference.begin - copied);
+        const auto &expanded = expandNode(nodeIdOf(reference.location), stack);
+        result.append(expanded.data(), expanded.size());
+        copied = reference.end;
+      }
+      result.append(raw.data() + copied, raw.size() - copied);
+
+      stack.pop_back();
+
+      n.expanded = std::move(result);
+      return *n.expanded;
+    }
+
+    const SecretString &SecretReferenceExpander::expand(const std::string &environment, const std::string &secretPath, const std::string &secretKey)
+    {
+      std::vector<std::string> stack;
+      return expandNode(nodeIdOf({environment, normalizeSecretPath(secretPath), secretKey}), stack);
+    }
+
+    std::vector<TSecret> SecretReferenceExpander::expand(const std::vector<TSecret> &secrets, const std::string &defaultSecretPath)
+    {
+      addSecrets(secrets, defaultSecretPath);
+
+      std::vector<TSecret> expanded;
+      expanded.reserve(secrets.size());
+      for (const auto &secret : secrets)
+      {
+        const auto &value = expand(
+            secret.getEnvironment(),
+            secret.getSecretPath().empty() ? defaultSecretPath : secret.getSecretPath(),
+            secret.getSecretKey());
+
+        expanded.push_back(secret);
+        expanded.back()._setSecretValue(value);
+      }
+      return expanded;
+    }
+  }
+}
@@ -0,0 +1,513 @@
+#include <libinfisical/InfisicalClient.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // On-disk layout (host byte order, checked through `byteOrderMark`):
+  //   SnapshotHeader | SnapshotEntry[count] (sorted by secret key) | string blob
+  // Every string is stored once in the blob and referenced by offset/length, so repeated values such as the workspace, environment and type are only stored once.
+  constexpr char SNAPSHOT_MAGIC[8] = {'I', 'N', 'F', 'S', 'N', 'A', 'P', '\0'};
+  // 2 added the rotation ID and the metadata
+  constexpr uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+  constexpr uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+
+  constexpr uint32_t FLAG_SKIP_MULTILINE_ENCODING = 1u << 0;
+  constexpr uint32_t FLAG_IS_ROTATED_SECRET = 1u << 1;
+  constexpr uint32_t FLAG_HAS_ROTATION_ID = 1u << 2;
+
+  enum SnapshotField
+  {
+    FIELD_SECRET_KEY,
+    FIELD_SECRET_VALUE,
+    FIELD_ID,
+    FIELD_WORKSPACE,
+    FIELD_ENVIRONMENT,
+    FIELD_TYPE,
+    FIELD_SECRET_PATH,
+    FIELD_ROTATION_ID,
+    // key/value pairs, each string as a u32 length followed by its bytes
+    FIELD_SECRET_METADATA,
+    FIELD_COUNT
+  };
+
+  struct SnapshotHeader
+  {
+    char magic[8];
+    uint32_t byteOrderMark;
+    uint32_t formatVersion;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t entriesOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+  };
+
+  struct SnapshotString
+  {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  struct SnapshotEntry
+  {
+    SnapshotString fields[FIELD_COUNT];
+    uint32_t version;
+    uint32_t flags;
+  };
+
+  const SnapshotHeader *headerOf(const char *data)
+  {
+    return reinterpret_cast<const SnapshotHeader *>(data);
+  }
+
+  const SnapshotEntry *entriesOf(const char *data)
+  {
+    return reinterpret_cast<const SnapshotEntry *>(data + headerOf(data)->entriesOffset);
+  }
+
+  std::string_view fieldOf(const char *data, const SnapshotEntry &entry, SnapshotField field)
+  {
+    const auto &str = entry.fields[field];
+    return std::string_view(data + headerOf(data)->stringsOffset + str.offset, str.length);
+  }
+
+  void appendMetadataString(std::string &out, const std::string &value)
+  {
+    const auto length = static_cast<uint32_t>(value.size());
+    out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.append(value);
+  }
+
+  bool readMetadataString(std::string_view &in, std::string_view &value)
+  {
+    uint32_t length;
+    if (in.size() < sizeof(length))
+    {
+      return false;
+    }
+    std::memcpy(&length, in.data(), sizeof(length));
+    in.remove_prefix(sizeof(length));
+    if (in.size() < length)
+    {
+      return false;
+    }
+    value = in.substr(0, length);
+    in.remove_prefix(length);
+    return true;
+  }
+
+  // calls onPair for every pair, returns false if the encoding is corrupt
+  template <typename OnPair>
+  bool forEachMetadata(std::string_view encoded, OnPair onPair)
+  {
+    std::string_view key, value;
+    while (!encoded.empty())
+    {
+      if (!readMetadataString(encoded, key) || !readMetadataString(encoded, value))
+      {
+        return false;
+      }
+      onPair(key, value);
+    }
+    return true;
+  }
+
+  std::string errnoMessage(const std::string &prefix, const std::string &path)
+  {
+    return prefix + " [path=" + path + "] [error=" + std::strerror(errno) + "]";
+  }
+
+#ifndef _WIN32
+  void writeAll(int fd, std::string_view buffer, const std::string &path)
+  {
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+      auto n = ::write(fd, buffer.data() + written, buffer.size() - written);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        throw Infisical::InfisicalError(errnoMessage("Failed to write secret snapshot", path), 0, "");
+      }
+      written += static_cast<size_t>(n);
+    }
+  }
+#endif
+}
+
+namespace Infisical
+{
+
+  namespace Secrets
+  {
+
+    SecretString SecretSnapshot::serialize(const std::vector<TSecret> &secrets)
+    {
+      // last occurrence of a key wins, same as ensureUniqueSecretsByKey()
+      std::unordered_map<std::string_view, const TSecret *> byKey;
+      byKey.reserve(secrets.size());
+      for (const auto &secret : secrets)
+      {
+        byKey[secret.getSecretKey()] = &secret;
+      }
+
+      std::vector<const TSecret *> sorted;
+      sorted.reserve(byKey.size());
+      for (const auto &pair : byKey)
+      {
+        sorted.push_back(pair.second);
+      }
+      std::sort(sorted.begin(), sorted.end(), [](const TSecret *a, const TSecret *b)
+                { return a->getSecretKey() < b->getSecretKey(); });
+
+      std::string strings;
+      std::unordered_map<std::string_view, SnapshotString> interned;
+      auto intern = [&strings, &interned](std::string_view value)
+      {
+        auto it = interned.find(value);
+        if (it != interned.end())
+        {
+          return it->second;
+        }
+        if (strings.size() + value.size() > UINT32_MAX)
+        {
+          throw InfisicalError("Secret snapshot exceeds the maximum supported size", 0, "");
+        }
+        SnapshotString str{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings.append(value.data(), value.size());
+        interned.emplace(value, str);
+        return str;
+      };
+
+      std::vector<SnapshotEntry> entries(sorted.size());
+      // interned by view, so every encoding has to stay where it is until the blob is complete
+      std::deque<std::string> metadata;
+      for (size_t i = 0; i < sorted.size(); i++)
+      {
+        const auto &secret = *sorted[i];
+        auto &entry = entries[i];
+        entry.fields[FIELD_SECRET_KEY] = intern(secret.getSecretKey());
+        entry.fields[FIELD_SECRET_VALUE] = intern(secret.getSecretValue());
+        entry.fields[FIELD_ID] = intern(secret.getId());
+        entry.fields[FIELD_WORKSPACE] = intern(secret.getWorkspace());
+        entry.fields[FIELD_ENVIRONMENT] = intern(secret.getEnvironment());
+        entry.fields[FIELD_TYPE] = intern(secret.getType());
+        entry.fields[FIELD_SECRET_PATH] = intern(secret.getSecretPath());
+        entry.fields[FIELD_ROTATION_ID] = intern(secret.getRotationId());
+
+        auto &encoded = metadata.emplace_back();
+        for (const auto &pair : secret.getSecretMetadata())
+        {
+          appendMetadataString(encoded, pair.getKey());
+          appendMetadataString(encoded, pair.getValue());
+        }
+        entry.fields[FIELD_SECRET_METADATA] = intern(encoded);
+
+        entry.version = secret.getVersion();
+        entry.flags = (secret.getSkipMultilineEncoding() ? FLAG_SKIP_MULTILINE_ENCODING : 0) |
+                      (secret.getIsRotatedSecret() ? FLAG_IS_ROTATED_SECRET : 0) |
+                      (secret.hasRotationId() ? FLAG_HAS_ROTATION_ID : 0);
+      }
+
+      SnapshotHeader header{};
+      std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+      header.byteOrderMark = SNAPSHOT_BYTE_ORDER_MARK;
+      header.formatVersion = SNAPSHOT_FORMAT_VERSION;
+      header.count = static_cast<uint32_t>(entries.size());
+      header.entriesOffset = sizeof(SnapshotHeader);
+      header.stringsOffset = header.entriesOffset + entries.size() * sizeof(SnapshotEntry);
+      header.stringsSize = strings.size();
+
+      SecretString buffer;
+      buffer.reserve(header.stringsOffset + strings.size());
+      buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+      buffer.append(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SnapshotEntry));
+      buffer.append(strings.data(), strings.size());
+      secure::wipe(strings);
+
+      return buffer;
+    }
+
+    void SecretSnapshot::write(const std::string &path, const std::vector<TSecret> &secrets)
+    {
+#ifdef _WIN32
+      throw InfisicalError("Secret snapshots are not supported on Windows", 0, "");
+#else
+      auto buffer = serialize(secrets);
+
+      // write next to the destination and rename, so readers never observe a partially written snapshot
+      const auto tmpPath = path + ".tmp." + std::to_string(::getpid());
+      int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+      if (fd < 0)
+      {
+        throw InfisicalError(errnoMessage("Failed to create secret snapshot", tmpPath), 0, "");
+      }
+
+      try
+      {
+        writeAll(fd, std::string_view(buffer.data(), buffer.size()), tmpPath);
+        if (::fsync(fd) != 0)
+        {
+          throw InfisicalError(errnoMessage("Failed to flush secret snapshot", tmpPath), 0, "");
+        }
+      }
+      catch (...)
+      {
+        ::close(fd);
+        ::unlink(tmpPath.c_str());
+        secure::wipe(buffer);
+        throw;
+      }
+      ::close(fd);
+      secure::wipe(buffer);
+
+      if (::rename(tmpPath.c_str(), path.c_str()) != 0)
+      {
+        auto msg = errnoMessage("Failed to move secret snapshot into place", path);
+        ::unlink(tmpPath.c_str());
+        throw InfisicalError(msg, 0, "");
+      }
+#endif
+    }
+
+    SecretSnapshot SecretSnapshot::open(const std::string &path)
+    {
+#ifdef _WIN32
+      throw InfisicalError("Secret snapshots are not supported on Windows", 0, "");
+#else
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+      {
+        throw InfisicalError(errnoMessage("Failed to open secret snapshot", path), 0, "");
+      }
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+      {
+        auto msg = errnoMessage("Failed to stat secret snapshot", path);
+        ::close(fd);
+        throw InfisicalError(msg, 0, "");
+      }
+
+      const auto size = static_cast<size_t>(st.st_size);
+      if (size < sizeof(SnapshotHeader))
+      {
+        ::close(fd);
+        throw InfisicalError("Invalid secret snapshot: file is truncated [path=" + path + "]", 0, "");
+      }
+
+      void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (mapped == MAP_FAILED)
+      {
+        throw InfisicalError(errnoMessage("Failed to map secret snapshot", path), 0, "");
+      }
+
+      SecretSnapshot snapshot;
+      snapshot._data = static_cast<const char *>(mapped);
+      snapshot._size = size;
+      snapshot._mapped = true;
+      snapshot.validate("path=" + path);
+      return snapshot;
+#endif
+    }
+
+    SecretSnapshot SecretSnapshot::fromBuffer(SecretString buffer)
+    {
+      SecretSnapshot snapshot;
+      snapshot._buffer = std::move(buffer);
+      snapshot._data = snapshot._buffer.data();
+      snapshot._size = snapshot._buffer.size();
+      if (snapshot._size < sizeof(SnapshotHeader))
+      {
+        throw InfisicalError("Invalid secret snapshot: buffer is truncated", 0, "");
+      }
+      snapshot.validate("source=buffer");
+      return snapshot;
+    }
+
+    void SecretSnapshot::validate(const std::string &source)
+    {
+      // validate everything once up front, so lookups never have to bounds check
+      const auto *header = headerOf(_data);
+      if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+          header->byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK ||
+          header->formatVersion != SNAPSHOT_FORMAT_VERSION)
+      {
+        throw InfisicalError("Invalid secret snapshot: unsupported format [" + source + "]", 0, "");
+      }
+
+      // every bound is checked against _size on its own and by subtraction, so a crafted header can't wrap a sum past the check
+      const uint64_t size = _size;
+      if (header->entriesOffset != sizeof(SnapshotHeader) || header->entriesOffset > size ||
+          header->count > (size - header->entriesOffset) / sizeof(SnapshotEntry) ||
+          header->stringsOffset != header->entriesOffset + uint64_t(header->count) * sizeof(SnapshotEntry) ||
+          header->stringsOffset > size ||
+          header->stringsSize != size - header->stringsOffset)
+      {
+        throw InfisicalError("Invalid secret snapshot: corrupt layout [" + source + "]", 0, "");
+      }
+
+      const auto *entries = entriesOf(_data);
+      for (uint32_t i = 0; i < header->count; i++)
+      {
+        for (const auto &str : entries[i].fields)
+        {
+          if (str.offset > header->stringsSize || str.length > header->stringsSize - str.offset)
+          {
+            throw InfisicalError("Invalid secret snapshot: corrupt string table [" + source + "]", 0, "");
+          }
+        }
+        if (!forEachMetadata(fieldOf(_data, entries[i], FIELD_SECRET_METADATA), [](std::string_view, std::string_view) {}))
+        {
+          throw InfisicalError("Invalid secret snapshot: corrupt metadata [" + source + "]", 0, "");
+        }
+        if (i > 0 && !(fieldOf(_data, entries[i - 1], FIELD_SECRET_KEY) < fieldOf(_data, entries[i], FIELD_SECRET_KEY)))
+        {
+          throw InfisicalError("Invalid secret snapshot: index is not sorted [" + source + "]", 0, "");
+        }
+      }
+
+      _count = header->count;
+    }
+
+    SecretSnapshot::SecretSnapshot(SecretSnapshot &&other) noexcept
+    {
+      *this = std::move(other);
+    }
+
+    SecretSnapshot &SecretSnapshot::operator=(SecretSnapshot &&other) noexcept
+    {
+      if (this != &other)
+      {
+        close();
+        _mapped = other._mapped;
+        _buffer = std::move(other._buffer);
+        // a moved small string lives inside the object, so the pointer has to be taken again
+        _data = _mapped ? other._data : _buffer.data();
+        _size = other._size;
+        _count = other._count;
+        other._data = nullptr;
+        other._size = 0;
+        other._count = 0;
+        other._mapped = false;
+      }
+      return *this;
+    }
+
+    SecretSnapshot::~SecretSnapshot()
+    {
+      close();
+    }
+
+    void SecretSnapshot::close()
+    {
+#ifndef _WIN32
+      if (_mapped && _data != nullptr)
+      {
+        ::munmap(const_cast<char *>(_data), _size);
+      }
+#endif
+      secure::wipe(_buffer);
+      _buffer.clear();
+      _mapped = false;
+      _data = nullptr;
+      _size = 0;
+      _count = 0;
+    }
+
+    SecretView SecretSnapshot::at(size_t index) const
+    {
+      if (index >= _count)
+      {
+        throw std::out_of_range("SecretSnapshot: index out of range");
+      }
+
+      const auto &entry = entriesOf(_data)[index];
+
+      SecretView view;
+      view.secretKey = fieldOf(_data, entry, FIELD_SECRET_KEY);
+      view.secretValue = fieldOf(_data, entry, FIELD_SECRET_VALUE);
+      view.id = fieldOf(_data, entry, FIELD_ID);
+      view.workspace = fieldOf(_data, entry, FIELD_WORKSPACE);
+      view.environment = fieldOf(_data, entry, FIELD_ENVIRONMENT);
+      view.type = fieldOf(_data, entry, FIELD_TYPE);
+      view.secretPath = fieldOf(_data, entry, FIELD_SECRET_PATH);
+      view.rotationId = fieldOf(_data, entry, FIELD_ROTATION_ID);
+      view.secretMetadata = fieldOf(_data, entry, FIELD_SECRET_METADATA);
+      view.version = entry.version;
+      view.skipMultilineEncoding = (entry.flags & FLAG_SKIP_MULTILINE_ENCODING) != 0;
+      view.isRotatedSecret = (entry.flags & FLAG_IS_ROTATED_SECRET) != 0;
+      view.hasRotationId = (entry.flags & FLAG_HAS_ROTATION_ID) != 0;
+      return view;
+    }
+
+    TSecret SecretView::toSecret() const
+    {
+      TSecret secret;
+      secret.id = id;
+      secret.workspace = workspace;
+      secret.environment = environment;
+      secret.version = version;
+      secret.type = type;
+      secret.secretKey = secretKey;
+      secret.secretValue.assign(secretValue.data(), secretValue.size());
+      secret.secretPath = secretPath;
+      secret.skipMultilineEncoding = skipMultilineEncoding;
+      secret.isRotatedSecret = isRotatedSecret;
+      if (hasRotationId)
+      {
+        secret.rotationId = std::string(rotationId);
+      }
+      secret.secretMetadata = getSecretMetadata();
+      return secret;
+    }
+
+    std::vector<SecretMetadata> SecretView::getSecretMetadata() const
+    {
+      std::vector<SecretMetadata> metadata;
+      // checked by validate(), can't fail here
+      forEachMetadata(secretMetadata, [&metadata](std::string_view key, std::string_view value)
+                      {
+                        auto &pair = metadata.emplace_back();
+                        pair.key = key;
+                        pair.value = value; });
+      return metadata;
+    }
+
+    std::optional<SecretView> SecretSnapshot::find(std::string_view secretKey) const
+    {
+      if (_count == 0)
+      {
+        return std::nullopt;
+      }
+
+      const auto *entries = entriesOf(_data);
+      const auto *end = entries + _count;
+      const auto *it = std::lower_bound(entries, end, secretKey, [this](const SnapshotEntry &entry, std::string_view key)
+                                        { return fieldOf(_data, entry, FIELD_SECRET_KEY) < key; });
+
+      if (it == end || fieldOf(_data, *it, FIELD_SECRET_KEY) != secretKey)
+      {
+        return std::nullopt;
+      }
+
+      return at(static_cast<size_t>(it - entries));
+    }
+  }
+}
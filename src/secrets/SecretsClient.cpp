@@ -2,6 +2,8 @@
 #include <iostream>
 #include "../../lib/json.hpp"
 #include <string>
+#include <future>
+#include <unordered_set>
 
 #include <cstdlib>
 #ifdef _WIN32
@@ -13,18 +15,19 @@ std::string convertBooleanToString(bool v)
   return v ? "true" : "false";
 }
 
-bool setEnvironmentVariable(const std::string &key, const std::string &value)
+bool setEnvironmentVariable(const std::string &key, const char *value, Infisical::Input::EnvironmentVariableOverwritePolicy policy)
 {
-  const char *current_value = std::getenv(key.c_str());
-  if (current_value != nullptr)
+  const bool overwrite = policy == Infisical::Input::EnvironmentVariableOverwritePolicy::OVERWRITE;
+
+#ifdef _WIN32
+  if (!overwrite && GetEnvironmentVariableA(key.c_str(), nullptr, 0) != 0)
   {
     return false;
   }
-
-#ifdef _WIN32
-  return SetEnvironmentVariableA(key.c_str(), value.c_str()) != 0;
+  return SetEnvironmentVariableA(key.c_str(), value) != 0;
 #else // POSIX systems
-  return setenv(key.c_str(), value.c_str(), 0) == 0;
+  // setenv() already checks for an existing variable when overwrite is 0, no need for a separate getenv() lookup
+  return setenv(key.c_str(), value, overwrite ? 1 : 0) == 0;
 #endif
 }
 
@@ -72,96 +75,262 @@ void omitEmptyFieldsFromMap(std::map<std::string, std::string> *params)
 
 void mergeSecretsAndImports(
     std::vector<Infisical::Secrets::TSecret> *secrets,
-    std::vector<Infisical::Secrets::TImports> &imports)
+    const nlohmann::json &imports)
 {
+  size_t total = secrets->size();
+  for (const auto &import : imports)
+  {
+    total += import.at("secrets").size();
+  }
 
-  auto secretExists = [&secrets](const std::string &key)
+  // reserved up front so the key views below stay valid while imported secrets are appended
+  secrets->reserve(total);
+
+  std::unordered_set<std::string_view> keys;
+  keys.reserve(total);
+  for (const auto &secret : *secrets)
   {
-    return std::any_of(secrets->begin(), secrets->end(), [&key](const Infisical::Secrets::TSecret &secret)
-                       { return secret.getSecretKey() == key; });
-  };
+    keys.insert(secret.getSecretKey());
+  }
 
   for (const auto &import : imports)
   {
-    // we don't mind if this is a reference or not in this case, as we'll copy it over to the destination secrets, and we need to do a direct modify, C/C++(1086)
-    for (auto importedSecret : import.getSecrets())
+    const auto &importPath = import.at("secretPath").get_ref<const std::string &>();
+    for (const auto &rawSecret : import.at("secrets"))
     {
-      // if the imported secret doesn't exist in the destination already, push it in
-      if (!secretExists(importedSecret.getSecretKey()))
+      // check the key straight from the json so shadowed secrets are never materialized
+      if (keys.count(rawSecret.at("secretKey").get_ref<const std::string &>()) > 0)
       {
-        importedSecret._setSecretPath(import.getSecretPath());
-        secrets->push_back(importedSecret);
+        continue;
       }
+
+      auto importedSecret = rawSecret.get<Infisical::Secrets::TSecret>();
+      importedSecret._setSecretPath(importPath);
+      secrets->push_back(std::move(importedSecret));
+      keys.insert(secrets->back().getSecretKey());
     }
   }
 }
 
 void ensureUniqueSecretsByKey(std::vector<Infisical::Secrets::TSecret> *secrets)
 {
+  auto &list = *secrets;
 
-  std::unordered_map<std::string, Infisical::Secrets::TSecret> secretMap;
+  // the last secret of a key wins
+  std::unordered_map<std::string_view, size_t> lastIndex;
+  lastIndex.reserve(list.size());
+  for (size_t i = 0; i < list.size(); i++)
+  {
+    lastIndex[list[i].getSecretKey()] = i;
+  }
 
-  // use the loop to overwrite the entry with the last secret of the same key
-  for (const auto &secret : *secrets)
+  // decided before compacting, moving secrets around invalidates the views held by the map
+  std::vector<bool> keep(list.size());
+  for (size_t i = 0; i < list.size(); i++)
   {
-    secretMap[secret.getSecretKey()] = secret;
+    keep[i] = lastIndex[list[i].getSecretKey()] == i;
   }
+  lastIndex.clear();
 
-  // clear the original secrets (this shouldn't fail. it couldn't. never ever. right?)
-  secrets->clear();
+  size_t out = 0;
+  for (size_t i = 0; i < list.size(); i++)
+  {
+    if (!keep[i])
+    {
+      continue;
+    }
+    if (out != i)
+    {
+      list[out] = std::move(list[i]);
+    }
+    out++;
+  }
+  list.erase(list.begin() + out, list.end());
+}
 
-  // refill the vector with only the unique secrets from the map
-  for (const auto &pair : secretMap)
+// a parsed response holds secret values in plain std::strings, they're wiped along with it
+struct ResponseJson : nlohmann::json
+{
+  explicit ResponseJson(nlohmann::json &&parsed) : nlohmann::json(std::move(parsed)) {}
+  ResponseJson(ResponseJson &&) = default;
+  ResponseJson &operator=(ResponseJson &&) = delete;
+  ~ResponseJson() { Infisical::secure::wipe(*this); }
+};
+
+// response bodies are read into a per-thread buffer that keeps its capacity between requests, so polling a large folder doesn't reallocate megabytes every time
+Infisical::Result<ResponseJson> tryRequestJson(
+    Infisical::http::HttpClient *httpClient,
+    Infisical::http::Method method,
+    const std::string &endpoint,
+    const std::map<std::string, std::string> &params,
+    const std::string &body)
+{
+  thread_local Infisical::SecretString buffer;
+
+  try
+  {
+    auto status = httpClient->tryRequestInto(method, endpoint, buffer, {}, params, body);
+    if (!status)
+    {
+      Infisical::secure::wipe(buffer);
+      return status.error();
+    }
+    ResponseJson parsed(nlohmann::json::parse(buffer.data(), buffer.data() + buffer.size()));
+    Infisical::secure::wipe(buffer);
+    return parsed;
+  }
+  catch (...)
   {
-    secrets->push_back(pair.second);
+    Infisical::secure::wipe(buffer);
+    throw;
   }
 }
 
+ResponseJson requestJson(
+    Infisical::http::HttpClient *httpClient,
+    Infisical::http::Method method,
+    const std::string &endpoint,
+    const std::map<std::string, std::string> &params,
+    const std::string &body)
+{
+  return tryRequestJson(httpClient, method, endpoint, params, body).value();
+}
+
+// misses remembered by tryGetSecret() at most, per client
+constexpr size_t MISSING_SECRET_CACHE_CAPACITY = 4096;
+
+// entries in each of the immutable version caches, per client
+constexpr size_t VERSION_CACHE_CAPACITY = 4096;
+
+// page size used to look for a version that isn't cached yet
+constexpr unsigned int SECRET_VERSIONS_PAGE_SIZE = 100;
+
+// identifies a getSecret() lookup of a specific version
+void secretLookupKeyOf(const Infisical::Input::GetSecretOptions &options, unsigned int version, std::string &key)
+{
+  key.assign(options.getProjectId())
+      .append(1, '\x1f')
+      .append(options.getEnvironment())
+      .append(1, '\x1f')
+      .append(options.getSecretPath())
+      .append(1, '\x1f')
+      .append(options.getType())
+      .append(1, '\x1f')
+      .append(options.getSecretKey())
+      .append(1, '\x1f')
+      .append(std::to_string(version))
+      .append(options.getExpandSecretReferences() ? "e" : "-");
+}
+
+// whether a versionedSecrets key is for this secret location, of any type and version
+bool isVersionedSecretAt(std::string_view key, const std::string &projectId, const std::string &environment, const std::string &secretPath, const std::string &secretKey)
+{
+  for (const auto *part : {&projectId, &environment, &secretPath})
+  {
+    if (key.substr(0, part->size()) != *part || key.size() <= part->size() || key[part->size()] != '\x1f')
+    {
+      return false;
+    }
+    key.remove_prefix(part->size() + 1);
+  }
+
+  // the type can't contain the separator, the key that follows it can't either
+  const auto typeEnd = key.find('\x1f');
+  if (typeEnd == std::string_view::npos)
+  {
+    return false;
+  }
+  key.remove_prefix(typeEnd + 1);
+  return key.substr(0, secretKey.size()) == secretKey && key.size() > secretKey.size() && key[secretKey.size()] == '\x1f';
+}
+
+// identifies a getSecret() lookup in the missing-secret cache
+void missingSecretKeyOf(const Infisical::Input::GetSecretOptions &options, std::string &key)
+{
+  secretLookupKeyOf(options, options.getVersion(), key);
+}
+
+std::string secretVersionKeyOf(const std::string &secretId, unsigned int version)
+{
+  return secretId + '\x1f' + std::to_string(version);
+}
+
+// a full cache is emptied rather than tracking which version was read last, old versions are rarely read often
+template <typename Value>
+void insertImmutable(std::unordered_map<std::string, Value> &cache, std::string key, const Value &value)
+{
+  if (cache.size() >= VERSION_CACHE_CAPACITY && cache.count(key) == 0)
+  {
+    cache.clear();
+  }
+  cache.emplace(std::move(key), value);
+}
+
+std::map<std::string, std::string> buildListSecretsParams(const Infisical::Input::ListSecretsOptions &options)
+{
+  auto params = std::map<std::string, std::string>{
+      {"workspaceId", options.getProjectId()},
+      {"environment", options.getEnvironment()},
+      {"recursive", convertBooleanToString(options.getRecursive())},
+      {"secretPath", options.getSecretPath()},
+      {"include_imports", "true"},
+      {"expandSecretReferences", convertBooleanToString(options.getExpandSecretReferences())}};
+  omitEmptyFieldsFromMap(&params);
+
+  if (options.getTagSlugs().size() > 0)
+  {
+    std::string tagSlugs = "";
+    for (const auto &tagSlug : options.getTagSlugs())
+    {
+      if (!tagSlugs.empty())
+      {
+        tagSlugs += ",";
+      }
+      tagSlugs += tagSlug;
+    }
+
+    params["tagSlugs"] = tagSlugs;
+  }
+
+  return params;
+}
+
 namespace Infisical
 {
 
   namespace Secrets
   {
 
-    SecretsClient::SecretsClient(http::HttpClient *httpClient)
-        : httpClient(httpClient)
+    SecretsClient::SecretsClient(http::HttpClient *httpClient, auth::AuthClient *authClient, agent::AgentClient *agentClient)
+        : httpClient(httpClient), authClient(authClient), agentClient(agentClient)
     {
     }
 
-    std::vector<TSecret> Secrets::SecretsClient::listSecrets(Infisical::Input::ListSecretsOptions options)
+    void SecretsClient::awaitAuthentication()
     {
-      auto params = std::map<std::string, std::string>{
-          {"workspaceId", options.getProjectId()},
-          {"environment", options.getEnvironment()},
-          {"recursive", convertBooleanToString(options.getRecursive())},
-          {"secretPath", options.getSecretPath()},
-          {"include_imports", "true"},
-          {"expandSecretReferences", convertBooleanToString(options.getExpandSecretReferences())}};
-      omitEmptyFieldsFromMap(&params);
-
-      if (options.getTagSlugs().size() > 0)
+      if (authClient != nullptr)
       {
-        std::string tagSlugs = "";
-        for (const auto &tagSlug : options.getTagSlugs())
-        {
-          if (!tagSlugs.empty())
-          {
-            tagSlugs += ",";
-          }
-          tagSlugs += tagSlug;
-        }
+        authClient->awaitLogin();
+      }
+    }
+
+    std::vector<TSecret> Secrets::SecretsClient::fetchSecrets(const Infisical::Input::ListSecretsOptions &options, bool viewSecretValue)
+    {
+      awaitAuthentication();
 
-        params["tagSlugs"] = tagSlugs;
+      auto params = buildListSecretsParams(options);
+      if (!viewSecretValue)
+      {
+        params["viewSecretValue"] = "false";
       }
 
-      auto parsedRaw = nlohmann::json::parse(this->httpClient->get("/api/v3/secrets/raw", {}, params).text);
+      auto parsedRaw = requestJson(this->httpClient, http::Method::GET, "/api/v3/secrets/raw", params, "");
       auto secrets = parsedRaw["secrets"].get<std::vector<TSecret>>();
-      auto rawImports = parsedRaw["imports"];
+      const auto &rawImports = parsedRaw["imports"];
 
       if (!rawImports.is_null())
       {
-        auto imports = rawImports.get<std::vector<TImports>>();
-        mergeSecretsAndImports(&secrets, imports);
+        mergeSecretsAndImports(&secrets, rawImports);
       }
 
       if (options.getRecursive())
@@ -169,19 +338,174 @@ namespace Infisical
         ensureUniqueSecretsByKey(&secrets);
       }
 
+      return secrets;
+    }
+
+    std::vector<TSecret> Secrets::SecretsClient::listSecrets(const Infisical::Input::ListSecretsOptions &options)
+    {
+      auto snapshot = agentClient != nullptr ? agentClient->listSecrets(options) : std::nullopt;
+
+      std::vector<TSecret> secrets;
+      if (snapshot)
+      {
+        secrets.reserve(snapshot->size());
+        for (size_t i = 0; i < snapshot->size(); i++)
+        {
+          secrets.push_back(snapshot->at(i).toSecret());
+        }
+      }
+      else
+      {
+        secrets = fetchSecrets(options, true);
+      }
+
       if (options.getAddSecretsToEnvironmentVariables())
       {
         for (const auto &secret : secrets)
         {
-          setEnvironmentVariable(secret.getSecretKey(), secret.getSecretValue());
+          setEnvironmentVariable(secret.getSecretKey(), secret.getSecretValue().c_str(), options.getEnvironmentVariableOverwritePolicy());
         }
       }
 
       return secrets;
     }
 
-    TSecret Secrets::SecretsClient::getSecret(Infisical::Input::GetSecretOptions options)
+    std::vector<TSecret> Secrets::SecretsClient::listSecretsMulti(const std::vector<Infisical::Input::ListSecretsOptions> &scopes)
     {
+      awaitAuthentication();
+
+      std::vector<std::future<std::vector<TSecret>>> pending;
+      pending.reserve(scopes.size());
+      for (const auto &scope : scopes)
+      {
+        pending.push_back(std::async(std::launch::async, [this, &scope, deadline = DeadlineScope::current()]()
+                                     {
+                                       // the caller's DeadlineScope is thread-local, so each fetch takes it along
+                                       std::optional<DeadlineScope> deadlineScope;
+                                       if (deadline)
+                                       {
+                                         deadlineScope.emplace(*deadline);
+                                       }
+                                       return fetchSecrets(scope, true); }));
+      }
+
+      // every request has to finish before rethrowing, the futures reference `scopes`
+      std::vector<std::vector<TSecret>> results(scopes.size());
+      std::exception_ptr error;
+      for (size_t i = 0; i < pending.size(); i++)
+      {
+        try
+        {
+          results[i] = pending[i].get();
+        }
+        catch (...)
+        {
+          if (!error)
+          {
+            error = std::current_exception();
+          }
+        }
+      }
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+
+      // later scopes take precedence, a key keeps the position where it first appeared
+      std::vector<std::pair<size_t, size_t>> winners;
+      std::unordered_map<std::string_view, size_t> byKey;
+      for (size_t scope = 0; scope < results.size(); scope++)
+      {
+        for (size_t i = 0; i < results[scope].size(); i++)
+        {
+          auto inserted = byKey.emplace(results[scope][i].getSecretKey(), winners.size());
+          if (inserted.second)
+          {
+            winners.emplace_back(scope, i);
+          }
+          else
+          {
+            winners[inserted.first->second] = {scope, i};
+          }
+        }
+      }
+      byKey.clear();
+
+      std::vector<TSecret> merged;
+      merged.reserve(winners.size());
+      for (const auto &winner : winners)
+      {
+        merged.push_back(std::move(results[winner.first][winner.second]));
+
+        const auto &options = scopes[winner.first];
+        if (options.getAddSecretsToEnvironmentVariables())
+        {
+          setEnvironmentVariable(merged.back().getSecretKey(), merged.back().getSecretValue().c_str(), options.getEnvironmentVariableOverwritePolicy());
+        }
+      }
+
+      return merged;
+    }
+
+    CompactSecretList Secrets::SecretsClient::listSecretsCompact(const Infisical::Input::ListSecretsOptions &options)
+    {
+      awaitAuthentication();
+
+      auto params = buildListSecretsParams(options);
+
+      auto parsedRaw = requestJson(this->httpClient, http::Method::GET, "/api/v3/secrets/raw", params, "");
+      auto secrets = CompactSecretList::fromListResponse(parsedRaw, options.getRecursive());
+
+      if (options.getAddSecretsToEnvironmentVariables())
+      {
+        for (size_t i = 0; i < secrets.size(); i++)
+        {
+          setEnvironmentVariable(std::string(secrets[i].getSecretKey()), std::string(secrets[i].getSecretValue()).c_str(), options.getEnvironmentVariableOverwritePolicy());
+        }
+      }
+
+      return secrets;
+    }
+
+    SecretChangeSet Secrets::SecretsClient::listSecretChanges(const Infisical::Input::ListSecretsOptions &options, std::vector<TSecret> &snapshot)
+    {
+      auto secrets = listSecrets(options);
+      auto changes = diffSecrets(snapshot, secrets);
+      snapshot = std::move(secrets);
+      return changes;
+    }
+
+    LazySecretList Secrets::SecretsClient::listSecretsLazy(const Infisical::Input::ListSecretsOptions &options)
+    {
+      auto secrets = fetchSecrets(options, false);
+      return LazySecretList::fromListing(this, std::move(options), std::move(secrets));
+    }
+
+    Result<TSecret> Secrets::SecretsClient::fetchSecret(const Infisical::Input::GetSecretOptions &options)
+    {
+      if (options.getVersion() > 0 && !options.getExpandSecretReferences())
+      {
+        thread_local std::string versionKey;
+        secretLookupKeyOf(options, options.getVersion(), versionKey);
+
+        std::lock_guard<std::mutex> lock(versionsMutex);
+        auto cached = versionedSecrets.find(versionKey);
+        if (cached != versionedSecrets.end())
+        {
+          return cached->second;
+        }
+      }
+
+      if (agentClient != nullptr)
+      {
+        auto snapshot = agentClient->getSecret(options);
+        if (snapshot && snapshot->size() == 1)
+        {
+          return snapshot->at(0).toSecret();
+        }
+      }
+
+      awaitAuthentication();
 
       auto params = std::map<std::string, std::string>{
           {"workspaceId", options.getProjectId()},
@@ -197,19 +521,211 @@ namespace Infisical
         params["version"] = std::to_string(options.getVersion());
       }
 
-      const auto url = "/api/v3/secrets/raw/" + options.getSecretKey();
+      thread_local std::string url;
+      url.assign("/api/v3/secrets/raw/").append(options.getSecretKey());
 
-      auto response = this->httpClient->get(url, {}, params).text;
+      auto parsedRaw = tryRequestJson(this->httpClient, http::Method::GET, url, params, "");
+      if (!parsedRaw)
+      {
+        return parsedRaw.error();
+      }
 
-      auto parsedRaw = nlohmann::json::parse(response);
+      auto secret = parsedRaw.value()["secret"].get<TSecret>();
+      rememberVersionedSecret(options, secret);
+      return secret;
+    }
 
-      auto secret = parsedRaw["secret"].get<TSecret>();
+    void Secrets::SecretsClient::rememberVersionedSecret(const Infisical::Input::GetSecretOptions &options, const TSecret &secret)
+    {
+      // an expanded value is resolved against the latest value of the secrets it refers to, so the same version can read differently
+      // later, and once the server has expanded it nothing shows it had references at all
+      if (secret.getVersion() == 0 || options.getExpandSecretReferences())
+      {
+        return;
+      }
 
-      return secret;
+      std::string key;
+      secretLookupKeyOf(options, secret.getVersion(), key);
+
+      std::lock_guard<std::mutex> lock(versionsMutex);
+      insertImmutable(versionedSecrets, std::move(key), secret);
+    }
+
+    std::vector<SecretVersion> Secrets::SecretsClient::listSecretVersions(const Infisical::Input::ListSecretVersionsOptions &options)
+    {
+      awaitAuthentication();
+
+      const auto params = std::map<std::string, std::string>{
+          {"offset", std::to_string(options.getOffset())},
+          {"limit", std::to_string(options.getLimit())}};
+
+      auto parsedRaw = requestJson(this->httpClient, http::Method::GET, "/api/v1/secret/" + options.getSecretId() + "/secret-versions", params, "");
+      auto versions = parsedRaw["secretVersions"].get<std::vector<SecretVersion>>();
+
+      std::lock_guard<std::mutex> lock(versionsMutex);
+      for (const auto &version : versions)
+      {
+        insertImmutable(secretVersions, secretVersionKeyOf(options.getSecretId(), version.getVersion()), version);
+      }
+      return versions;
+    }
+
+    std::optional<SecretVersion> Secrets::SecretsClient::getSecretVersion(const std::string &secretId, unsigned int version)
+    {
+      // versions start at 1
+      if (version == 0)
+      {
+        return std::nullopt;
+      }
+
+      const auto key = secretVersionKeyOf(secretId, version);
+      {
+        std::lock_guard<std::mutex> lock(versionsMutex);
+        auto cached = secretVersions.find(key);
+        if (cached != secretVersions.end())
+        {
+          return cached->second;
+        }
+      }
+
+      // newest first, so a version lower than the last one on a page can only be on a later page
+      for (unsigned int offset = 0;; offset += SECRET_VERSIONS_PAGE_SIZE)
+      {
+        const auto page = listSecretVersions(Input::ListSecretVersionsOptionsBuilder()
+                                                 .withSecretId(secretId)
+                                                 .withOffset(offset)
+                                                 .withLimit(SECRET_VERSIONS_PAGE_SIZE)
+                                                 .build());
+        for (const auto &candidate : page)
+        {
+          if (candidate.getVersion() == version)
+          {
+            return candidate;
+          }
+        }
+        if (page.size() < SECRET_VERSIONS_PAGE_SIZE || page.back().getVersion() < version)
+        {
+          return std::nullopt;
+        }
+      }
+    }
+
+    TSecret Secrets::SecretsClient::getSecret(const Infisical::Input::GetSecretOptions &options)
+    {
+      return fetchSecret(options).value();
+    }
+
+    std::optional<TSecret> Secrets::SecretsClient::tryGetSecret(const Infisical::Input::GetSecretOptions &options)
+    {
+      thread_local std::string missingKey;
+      missingSecretKeyOf(options, missingKey);
+
+      bool cacheMisses;
+      uint64_t generation;
+      {
+        std::lock_guard<std::mutex> lock(missingSecretsMutex);
+        cacheMisses = missingSecretTtl.count() > 0;
+        generation = missingSecretsGeneration;
+
+        auto missing = missingSecrets.find(missingKey);
+        if (cacheMisses && missing != missingSecrets.end())
+        {
+          if (std::chrono::steady_clock::now() < missing->second)
+          {
+            return std::nullopt;
+          }
+          missingSecrets.erase(missing);
+        }
+      }
+
+      auto secret = fetchSecret(options);
+      if (secret)
+      {
+        return std::move(secret).value();
+      }
+      if (secret.error().getStatusCode() != 404)
+      {
+        throw secret.error();
+      }
+
+      if (cacheMisses)
+      {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(missingSecretsMutex);
+        // a secret created while the request was in flight may be the one that was just reported missing
+        if (generation != missingSecretsGeneration)
+        {
+          return std::nullopt;
+        }
+
+        // probing many distinct keys shouldn't grow the cache forever, expired entries go first
+        if (missingSecrets.size() >= MISSING_SECRET_CACHE_CAPACITY)
+        {
+          for (auto it = missingSecrets.begin(); it != missingSecrets.end();)
+          {
+            it = now < it->second ? std::next(it) : missingSecrets.erase(it);
+          }
+          if (missingSecrets.size() >= MISSING_SECRET_CACHE_CAPACITY)
+          {
+            missingSecrets.clear();
+          }
+        }
+        missingSecrets[missingKey] = now + missingSecretTtl;
+      }
+      return std::nullopt;
+    }
+
+    void Secrets::SecretsClient::setMissingSecretCacheTtl(std::chrono::milliseconds ttl)
+    {
+      std::lock_guard<std::mutex> lock(missingSecretsMutex);
+      missingSecretTtl = ttl;
+      missingSecrets.clear();
+      missingSecretsGeneration++;
+    }
+
+    void Secrets::SecretsClient::prepareFork()
+    {
+      missingSecretsMutex.lock();
+      versionsMutex.lock();
+    }
+
+    void Secrets::SecretsClient::afterForkInParent()
+    {
+      versionsMutex.unlock();
+      missingSecretsMutex.unlock();
+    }
+
+    void Secrets::SecretsClient::afterForkInChild()
+    {
+      versionsMutex.unlock();
+      missingSecretsMutex.unlock();
+    }
+
+    void Secrets::SecretsClient::forgetVersionedSecrets(const std::string &projectId, const std::string &environment, const std::string &secretPath, const std::string &secretKey)
+    {
+      std::lock_guard<std::mutex> lock(versionsMutex);
+      for (auto it = versionedSecrets.begin(); it != versionedSecrets.end();)
+      {
+        if (isVersionedSecretAt(it->first, projectId, environment, secretPath, secretKey))
+        {
+          it = versionedSecrets.erase(it);
+          continue;
+        }
+        it++;
+      }
+    }
+
+    void Secrets::SecretsClient::forgetMissingSecrets()
+    {
+      std::lock_guard<std::mutex> lock(missingSecretsMutex);
+      missingSecrets.clear();
+      missingSecretsGeneration++;
     }
 
-    TSecret Secrets::SecretsClient::updateSecret(Infisical::Input::UpdateSecretOptions options)
+    TSecret Secrets::SecretsClient::updateSecret(const Infisical::Input::UpdateSecretOptions &options)
     {
+      awaitAuthentication();
 
       nlohmann::json bodyJson = {
           {"environment", options.getEnvironment()},
@@ -232,16 +748,23 @@ namespace Infisical
 
       auto url = "/api/v3/secrets/raw/" + options.getSecretKey();
 
-      auto response = this->httpClient->patch(url, {}, bodyJson.dump()).text;
-
-      auto parsedRaw = nlohmann::json::parse(response);
+      auto parsedRaw = requestJson(this->httpClient, http::Method::PATCH, url, {}, bodyJson.dump());
+      forgetMissingSecrets();
+      // a renamed secret's versions are no longer readable under the old name, and the new name may have had a deleted predecessor
+      if (!options.getNewSecretKey().empty())
+      {
+        forgetVersionedSecrets(options.getProjectId(), options.getEnvironment(), options.getSecretPath(), options.getSecretKey());
+        forgetVersionedSecrets(options.getProjectId(), options.getEnvironment(), options.getSecretPath(), options.getNewSecretKey());
+      }
       auto secret = parsedRaw["secret"].get<TSecret>();
 
       return secret;
     }
 
-    TSecret Secrets::SecretsClient::createSecret(Infisical::Input::CreateSecretOptions options)
+    TSecret Secrets::SecretsClient::createSecret(const Infisical::Input::CreateSecretOptions &options)
     {
+      awaitAuthentication();
+
       nlohmann::json bodyJson = {
           {"environment", options.getEnvironment()},
           {"workspaceId", options.getProjectId()},
@@ -255,14 +778,18 @@ namespace Infisical
       omitEmptyFieldsFromJson(&bodyJson);
 
       auto url = "/api/v3/secrets/raw/" + options.getSecretKey();
-      auto parsedRaw = nlohmann::json::parse(this->httpClient->post(url, {}, bodyJson.dump()).text);
+      auto parsedRaw = requestJson(this->httpClient, http::Method::POST, url, {}, bodyJson.dump());
+      forgetMissingSecrets();
+      // the new secret starts again at version 1, versions cached for a deleted predecessor of the same name don't belong to it
+      forgetVersionedSecrets(options.getProjectId(), options.getEnvironment(), options.getSecretPath(), options.getSecretKey());
       auto secret = parsedRaw["secret"].get<TSecret>();
 
       return secret;
     }
 
-    TSecret Secrets::SecretsClient::deleteSecret(Infisical::Input::DeleteSecretOptions options)
+    TSecret Secrets::SecretsClient::deleteSecret(const Infisical::Input::DeleteSecretOptions &options)
     {
+      awaitAuthentication();
 
       nlohmann::json bodyJson = {
           {"environment", options.getEnvironment()},
@@ -274,7 +801,8 @@ namespace Infisical
 
       auto url = "/api/v3/secrets/raw/" + options.getSecretKey();
 
-      auto parsedRaw = nlohmann::json::parse(this->httpClient->del(url, {}, bodyJson.dump()).text);
+      auto parsedRaw = requestJson(this->httpClient, http::Method::DELETE, url, {}, bodyJson.dump());
+      forgetVersionedSecrets(options.getProjectId(), options.getEnvironment(), options.getSecretPath(), options.getSecretKey());
 
       auto secret = parsedRaw["secret"].get<TSecret>();
 
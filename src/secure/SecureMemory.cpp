@@ -0,0 +1,314 @@
+#include <libinfisical/InfisicalClient.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // size classes are powers of two from 16 bytes up to 16 KiB, anything larger gets its own locked mapping
+  constexpr size_t MIN_CLASS_SHIFT = 4;
+  constexpr size_t MAX_CLASS_SHIFT = 14;
+  constexpr size_t CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+  constexpr size_t MAX_POOLED_SIZE = size_t(1) << MAX_CLASS_SHIFT;
+  constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  size_t sizeClassOf(size_t size)
+  {
+    size_t cls = 0;
+    while ((size_t(1) << (cls + MIN_CLASS_SHIFT)) < size)
+    {
+      cls++;
+    }
+    return cls;
+  }
+
+  size_t pageSize()
+  {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+#endif
+  }
+
+  size_t roundToPages(size_t size)
+  {
+    const auto page = pageSize();
+    return (size + page - 1) / page * page;
+  }
+
+  class SecurePool
+  {
+  public:
+    void *allocate(size_t size)
+    {
+      if (size == 0)
+      {
+        size = 1;
+      }
+
+      if (size > MAX_POOLED_SIZE)
+      {
+        const auto mapped = roundToPages(size);
+        void *data = mapLocked(mapped);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_largeMappings[data] = mapped;
+        return data;
+      }
+
+      const auto cls = sizeClassOf(size);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_freeLists[cls] == nullptr)
+      {
+        refill(cls);
+      }
+
+      auto *block = m_freeLists[cls];
+      m_freeLists[cls] = block->next;
+      return block;
+    }
+
+    void deallocate(void *data, size_t size)
+    {
+      if (data == nullptr)
+      {
+        return;
+      }
+      if (size == 0)
+      {
+        size = 1;
+      }
+
+      if (size > MAX_POOLED_SIZE)
+      {
+        const auto mapped = roundToPages(size);
+        Infisical::secure::wipe(data, mapped);
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_largeMappings.erase(data);
+        }
+        unmapLocked(data, mapped);
+        return;
+      }
+
+      const auto cls = sizeClassOf(size);
+      Infisical::secure::wipe(data, size_t(1) << (cls + MIN_CLASS_SHIFT));
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto *block = static_cast<FreeBlock *>(data);
+      block->next = m_freeLists[cls];
+      m_freeLists[cls] = block;
+    }
+
+    bool isLocked() const { return !m_lockFailed; }
+
+    void lockForFork() { m_mutex.lock(); }
+    void unlockAfterFork() { m_mutex.unlock(); }
+
+    // mlock() isn't inherited by fork(), called in the child with m_mutex still held from lockForFork()
+    void relockAfterFork()
+    {
+#ifndef _WIN32
+      for (auto *chunk : m_chunks)
+      {
+        if (::mlock(chunk, CHUNK_SIZE) != 0)
+        {
+          m_lockFailed = true;
+        }
+      }
+      for (const auto &[data, size] : m_largeMappings)
+      {
+        if (::mlock(data, size) != 0)
+        {
+          m_lockFailed = true;
+        }
+      }
+#endif
+    }
+
+  private:
+    // carve a fresh chunk into blocks of the given class, called with m_mutex held
+    void refill(size_t cls)
+    {
+      const auto blockSize = size_t(1) << (cls + MIN_CLASS_SHIFT);
+      auto *chunk = static_cast<char *>(mapLocked(CHUNK_SIZE));
+      m_chunks.push_back(chunk);
+
+      for (size_t offset = 0; offset + blockSize <= CHUNK_SIZE; offset += blockSize)
+      {
+        auto *block = reinterpret_cast<FreeBlock *>(chunk + offset);
+        block->next = m_freeLists[cls];
+        m_freeLists[cls] = block;
+      }
+    }
+
+    void *mapLocked(size_t size)
+    {
+#ifdef _WIN32
+      void *data = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+      if (data == nullptr)
+      {
+        throw std::bad_alloc();
+      }
+      if (!VirtualLock(data, size))
+      {
+        m_lockFailed = true;
+      }
+#else
+      void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (data == MAP_FAILED)
+      {
+        throw std::bad_alloc();
+      }
+      if (::mlock(data, size) != 0)
+      {
+        // keep going without locking, the memory is still zeroized on release
+        m_lockFailed = true;
+      }
+#ifdef MADV_DONTDUMP
+      ::madvise(data, size, MADV_DONTDUMP);
+#endif
+#endif
+      return data;
+    }
+
+    void unmapLocked(void *data, size_t size)
+    {
+#ifdef _WIN32
+      VirtualUnlock(data, size);
+      VirtualFree(data, 0, MEM_RELEASE);
+#else
+      ::munlock(data, size);
+      ::munmap(data, size);
+#endif
+    }
+
+    std::mutex m_mutex;
+    FreeBlock *m_freeLists[CLASS_COUNT] = {};
+    // every mapping the pool owns, so a forked child can lock them again
+    std::vector<void *> m_chunks;
+    std::unordered_map<void *, size_t> m_largeMappings;
+    std::atomic<bool> m_lockFailed{false};
+  };
+
+  SecurePool &pool()
+  {
+    // intentionally leaked, secrets may still be released from static destructors after main() returns
+    static auto *instance = new SecurePool();
+    return *instance;
+  }
+}
+
+namespace Infisical
+{
+
+  namespace secure
+  {
+
+    void wipe(void *data, size_t size)
+    {
+      if (data == nullptr || size == 0)
+      {
+        return;
+      }
+#if defined(_WIN32)
+      SecureZeroMemory(data, size);
+#elif defined(__GLIBC__) || defined(__OpenBSD__) || defined(__FreeBSD__)
+      explicit_bzero(data, size);
+#else
+      // volatile writes can't be elided by the optimizer
+      volatile unsigned char *p = static_cast<volatile unsigned char *>(data);
+      while (size--)
+      {
+        *p++ = 0;
+      }
+#endif
+    }
+
+    void wipe(nlohmann::json &value)
+    {
+      // walked with an explicit stack, the nesting depth comes from whoever wrote the document
+      std::vector<nlohmann::json *> pending{&value};
+      while (!pending.empty())
+      {
+        auto *node = pending.back();
+        pending.pop_back();
+        if (node->is_string())
+        {
+          wipe(node->get_ref<std::string &>());
+        }
+        else if (node->is_number_integer() && !node->is_number_unsigned())
+        {
+          auto &number = node->get_ref<nlohmann::json::number_integer_t &>();
+          wipe(&number, sizeof(number));
+        }
+        else if (node->is_number_unsigned())
+        {
+          auto &number = node->get_ref<nlohmann::json::number_unsigned_t &>();
+          wipe(&number, sizeof(number));
+        }
+        else if (node->is_number_float())
+        {
+          auto &number = node->get_ref<nlohmann::json::number_float_t &>();
+          wipe(&number, sizeof(number));
+        }
+        else if (node->is_structured())
+        {
+          for (auto &child : *node)
+          {
+            pending.push_back(&child);
+          }
+        }
+      }
+    }
+
+    void *allocate(size_t size)
+    {
+      return pool().allocate(size);
+    }
+
+    void deallocate(void *data, size_t size)
+    {
+      pool().deallocate(data, size);
+    }
+
+    bool isMemoryLocked()
+    {
+      return pool().isLocked();
+    }
+
+    void prepareFork()
+    {
+      pool().lockForFork();
+    }
+
+    void afterForkInParent()
+    {
+      pool().unlockAfterFork();
+    }
+
+    void afterForkInChild()
+    {
+      auto &instance = pool();
+      instance.relockAfterFork();
+      instance.unlockAfterFork();
+    }
+  }
+}